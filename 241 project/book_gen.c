@@ -0,0 +1,476 @@
+// book_gen.c - offline opening book generator for the hard bot
+//
+// Solves every position up to a given number of stones and writes the
+// scores in the 7x6.book format read by bot_hard.c (6-byte header, then
+// the partial-key array, then the value array). Mirrored positions share
+// one entry through the book's symmetric base-3 key.
+//
+// The work is cut into units: every position shallower than the split
+// ply is a unit of its own, and every position at the split ply is a unit
+// covering its whole subtree. Worker threads take units in order; the
+// main thread checkpoints the table plus the list of finished units, so
+// an interrupted run picks up where it stopped when started again with
+// the same options.
+//
+// build: gcc -O2 -pthread book_gen.c bot_hard.c -o book_gen -lm
+// run:   ./book_gen -d 16 -l 28        (from the directory holding 7x6.book,
+//                                       which speeds up the shallow solves)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "bot_hard.h"
+
+#define WIDTH      7
+#define HEIGHT     6
+#define MIN_SCORE  (-(WIDTH * HEIGHT) / 2 + 3)   // same encoding as Pascal's book
+#define SPLIT_PLY  6
+#define MAX_THREADS 64
+
+typedef struct {
+    uint64_t position;   // stones of the player to move
+    uint64_t mask;       // all stones
+    int      moves;
+} Node;
+
+static struct {
+    // options
+    int         depth;
+    int         logSize;
+    int         threads;
+    int         checkpointSec;
+    size_t      hashMB;
+    char        out[1024];
+    char        progress[1100];
+
+    // book table, same layout as the file payload
+    size_t      size;
+    int         keyBytes;
+    uint8_t    *keys;
+    uint8_t    *values;
+    uint8_t    *seen;        // bit per slot: stored (and expanded) by this run
+    pthread_mutex_t lock;    // table writes, unit bookkeeping, checkpoints
+
+    // work units
+    Node       *units;
+    size_t      unitCount;
+    size_t      unitCap;
+    int         splitPly;
+    uint8_t    *done;
+    atomic_size_t nextUnit;
+    size_t      doneCount;
+
+    atomic_ullong solved;
+    atomic_ullong collisions;
+} G;
+
+// ---------------------------------------------------------------
+// Bitboards (same layout as bot_hard.c: 7 bits per column)
+// ---------------------------------------------------------------
+
+static int can_play(const Node *n, int col) {
+    return (n->mask & (1ULL << (col * 7 + HEIGHT - 1))) == 0;
+}
+
+static void play(Node *n, int col) {
+    uint64_t move = (n->mask + (1ULL << (col * 7))) & (((1ULL << HEIGHT) - 1) << (col * 7));
+    n->position ^= n->mask;
+    n->mask |= move;
+    n->moves++;
+}
+
+// did the player who just moved connect four?
+static int last_move_won(const Node *n) {
+    uint64_t bb = n->position ^ n->mask;
+    static const int dirs[4] = {1, 6, 7, 8};
+    for (int i = 0; i < 4; i++) {
+        uint64_t m = bb & (bb >> dirs[i]);
+        if (m & (m >> (2 * dirs[i]))) return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------
+// Book table
+// ---------------------------------------------------------------
+
+static size_t next_prime(size_t n) {
+    for (;; n++) {
+        int prime = (n >= 2);
+        for (size_t d = 2; prime && d * d <= n; d++) {
+            if (n % d == 0) prime = 0;
+        }
+        if (prime) return n;
+    }
+}
+
+static uint64_t partial_key(uint64_t key) {
+    return G.keyBytes >= 8 ? key : key & ((1ULL << (8 * G.keyBytes)) - 1);
+}
+
+static uint64_t slot_key(size_t idx) {
+    uint64_t k = 0;
+    for (int i = 0; i < G.keyBytes; i++) {
+        k |= (uint64_t)G.keys[idx * G.keyBytes + i] << (8 * i);   // little endian
+    }
+    return k;
+}
+
+// 1 if the slot holds `key`; *seenOut tells whether this run stored it
+static int table_has(uint64_t key, int *seenOut) {
+    size_t idx = (size_t)(key % G.size);
+    pthread_mutex_lock(&G.lock);
+    int found = G.values[idx] != 0 && slot_key(idx) == partial_key(key);
+    *seenOut = found && (G.seen[idx >> 3] & (1u << (idx & 7)));
+    pthread_mutex_unlock(&G.lock);
+    return found;
+}
+
+static void table_store(uint64_t key, int score, int markSeen) {
+    size_t idx = (size_t)(key % G.size);
+    uint64_t pk = partial_key(key);
+
+    pthread_mutex_lock(&G.lock);
+    if (G.values[idx] != 0 && slot_key(idx) != pk) {
+        atomic_fetch_add(&G.collisions, 1);
+    }
+    for (int i = 0; i < G.keyBytes; i++) {
+        G.keys[idx * G.keyBytes + i] = (uint8_t)(pk >> (8 * i));
+    }
+    G.values[idx] = (uint8_t)(score - MIN_SCORE + 1);
+    if (markSeen) {
+        G.seen[idx >> 3] |= (uint8_t)(1u << (idx & 7));
+    } else {
+        G.seen[idx >> 3] &= (uint8_t)~(1u << (idx & 7));
+    }
+    pthread_mutex_unlock(&G.lock);
+}
+
+static void mark_seen(uint64_t key) {
+    size_t idx = (size_t)(key % G.size);
+    pthread_mutex_lock(&G.lock);
+    G.seen[idx >> 3] |= (uint8_t)(1u << (idx & 7));
+    pthread_mutex_unlock(&G.lock);
+}
+
+// ---------------------------------------------------------------
+// Checkpoint / resume
+// ---------------------------------------------------------------
+
+static int write_file(const char *path, const void *a, size_t na,
+                      const void *b, size_t nb, const void *c, size_t nc) {
+    char tmp[1200];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return 0;
+    int ok = fwrite(a, 1, na, f) == na &&
+             fwrite(b, 1, nb, f) == nb &&
+             fwrite(c, 1, nc, f) == nc;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        remove(tmp);
+        return 0;
+    }
+    return 1;
+}
+
+static void book_header(uint8_t header[6]) {
+    header[0] = WIDTH;
+    header[1] = HEIGHT;
+    header[2] = (uint8_t)G.depth;
+    header[3] = (uint8_t)G.keyBytes;
+    header[4] = 1;
+    header[5] = (uint8_t)G.logSize;
+}
+
+// book first, then the list of finished units, both atomically renamed
+static void checkpoint(void) {
+    uint8_t header[6];
+    book_header(header);
+
+    pthread_mutex_lock(&G.lock);
+    char line[128];
+    int n = snprintf(line, sizeof(line), "book_gen %d %d %d %d %zu\n",
+                     G.depth, G.logSize, G.keyBytes, G.splitPly, G.unitCount);
+    if (!write_file(G.out, header, 6, G.keys, G.size * G.keyBytes, G.values, G.size) ||
+        !write_file(G.progress, line, (size_t)n, G.done, G.unitCount, "", 0)) {
+        fprintf(stderr, "book_gen: checkpoint to '%s' failed\n", G.out);
+    }
+    pthread_mutex_unlock(&G.lock);
+}
+
+// reload a previous run with the same options; 0 if there is none
+static int resume(void) {
+    FILE *p = fopen(G.progress, "rb");
+    if (!p) return 0;
+
+    int depth, logSize, keyBytes, splitPly;
+    size_t unitCount;
+    if (fscanf(p, "book_gen %d %d %d %d %zu", &depth, &logSize, &keyBytes,
+               &splitPly, &unitCount) != 5 || fgetc(p) != '\n' ||
+        depth != G.depth || logSize != G.logSize || keyBytes != G.keyBytes ||
+        splitPly != G.splitPly || unitCount != G.unitCount) {
+        fprintf(stderr, "book_gen: '%s' was written with other options; "
+                        "remove it to start over\n", G.progress);
+        exit(1);
+    }
+    if (fread(G.done, 1, G.unitCount, p) != G.unitCount) {
+        fprintf(stderr, "book_gen: '%s' is truncated\n", G.progress);
+        exit(1);
+    }
+    fclose(p);
+
+    FILE *f = fopen(G.out, "rb");
+    uint8_t header[6], expect[6];
+    book_header(expect);
+    if (!f || fread(header, 1, 6, f) != 6 || memcmp(header, expect, 6) != 0 ||
+        fread(G.keys, G.keyBytes, G.size, f) != G.size ||
+        fread(G.values, 1, G.size, f) != G.size) {
+        fprintf(stderr, "book_gen: cannot reload checkpoint '%s'\n", G.out);
+        exit(1);
+    }
+    fclose(f);
+
+    for (size_t i = 0; i < G.unitCount; i++) {
+        G.doneCount += G.done[i];
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------
+// Work units
+// ---------------------------------------------------------------
+
+typedef struct {
+    uint64_t key;
+    Node     node;
+} KeyedNode;
+
+static KeyedNode *collected;
+static size_t collectedCount, collectedCap;
+
+static void collect(const Node *n) {
+    if (collectedCount == collectedCap) {
+        collectedCap = collectedCap ? collectedCap * 2 : 1024;
+        collected = realloc(collected, collectedCap * sizeof(*collected));
+        if (!collected) { perror("book_gen"); exit(1); }
+    }
+    collected[collectedCount].key  = hardBotBookKey(n->position, n->mask, n->moves);
+    collected[collectedCount].node = *n;
+    collectedCount++;
+
+    if (n->moves == G.splitPly) return;
+    for (int c = 0; c < WIDTH; c++) {
+        if (!can_play(n, c)) continue;
+        Node child = *n;
+        play(&child, c);
+        if (!last_move_won(&child)) collect(&child);
+    }
+}
+
+static int cmp_keyed(const void *a, const void *b) {
+    const KeyedNode *x = a, *y = b;
+    if (x->node.moves != y->node.moves) return x->node.moves - y->node.moves;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+// one unit per distinct (mirror-merged) position up to the split ply,
+// shallowest first, in a fixed order so a resumed run matches
+static void build_units(void) {
+    Node root = {0, 0, 0};
+    collect(&root);
+    qsort(collected, collectedCount, sizeof(*collected), cmp_keyed);
+
+    G.units = malloc(collectedCount * sizeof(Node));
+    if (!G.units) { perror("book_gen"); exit(1); }
+    for (size_t i = 0; i < collectedCount; i++) {
+        if (i > 0 && collected[i].key == collected[i - 1].key &&
+            collected[i].node.moves == collected[i - 1].node.moves) continue;
+        G.units[G.unitCount++] = collected[i].node;
+    }
+    free(collected);
+}
+
+static void solve_store(const Node *n, uint64_t key, int tid, int markSeen) {
+    int score;
+    if (!solveHardBotPosition(n->position, n->mask, n->moves, tid, &score)) {
+        fprintf(stderr, "book_gen: solver interrupted\n");   // limits are infinite
+        exit(1);
+    }
+    table_store(key, score, markSeen);
+    atomic_fetch_add(&G.solved, 1);
+}
+
+// solve n and everything below it down to the book depth
+static void explore(const Node *n, int tid) {
+    uint64_t key = hardBotBookKey(n->position, n->mask, n->moves);
+    int seen;
+    if (!table_has(key, &seen)) {
+        solve_store(n, key, tid, 1);
+    } else if (seen) {
+        return;                              // this run already expanded it
+    } else {
+        mark_seen(key);                      // solved before a resume: expand only
+    }
+
+    if (n->moves == G.depth) return;
+    for (int c = 0; c < WIDTH; c++) {
+        if (!can_play(n, c)) continue;
+        Node child = *n;
+        play(&child, c);
+        if (!last_move_won(&child) && child.moves < WIDTH * HEIGHT) explore(&child, tid);
+    }
+}
+
+static void *worker(void *arg) {
+    int tid = (int)(intptr_t)arg;
+    for (;;) {
+        size_t i = atomic_fetch_add(&G.nextUnit, 1);
+        if (i >= G.unitCount) break;
+        if (G.done[i]) continue;
+
+        const Node *n = &G.units[i];
+        if (n->moves < G.splitPly) {
+            solve_store(n, hardBotBookKey(n->position, n->mask, n->moves), tid, 0);
+        } else {
+            explore(n, tid);
+        }
+
+        pthread_mutex_lock(&G.lock);
+        G.done[i] = 1;
+        G.doneCount++;
+        pthread_mutex_unlock(&G.lock);
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------
+// main
+// ---------------------------------------------------------------
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-d depth] [-l log2_size] [-t threads] [-m hash_mb]\n"
+            "          [-c checkpoint_sec] [-o output]\n"
+            "  -d  solve every position with up to this many stones (default 16)\n"
+            "  -l  book table holds next_prime(2^l) entries (default 28)\n"
+            "  -t  worker threads (default: one per online CPU, max %d)\n"
+            "  -m  solver transposition table in MB (default 1024)\n"
+            "  -c  seconds between checkpoints (default 300)\n"
+            "  -o  output file (default 7x6_d<depth>.book)\n",
+            prog, MAX_THREADS);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    G.depth = 16;
+    G.logSize = 28;
+    G.threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    G.hashMB = 1024;
+    G.checkpointSec = 300;
+    G.out[0] = '\0';
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:l:t:m:c:o:h")) != -1) {
+        switch (opt) {
+        case 'd': G.depth = atoi(optarg); break;
+        case 'l': G.logSize = atoi(optarg); break;
+        case 't': G.threads = atoi(optarg); break;
+        case 'm': G.hashMB = (size_t)atol(optarg); break;
+        case 'c': G.checkpointSec = atoi(optarg); break;
+        case 'o': snprintf(G.out, sizeof(G.out), "%s", optarg); break;
+        default:  usage(argv[0]);
+        }
+    }
+    if (G.depth < 1 || G.depth > WIDTH * HEIGHT - 1 || G.logSize < 8 ||
+        G.logSize > 40 || G.checkpointSec < 1) {
+        usage(argv[0]);
+    }
+    if (G.threads < 1) G.threads = 1;
+    if (G.threads > MAX_THREADS) G.threads = MAX_THREADS;
+    if (!G.out[0]) snprintf(G.out, sizeof(G.out), "7x6_d%d.book", G.depth);
+    snprintf(G.progress, sizeof(G.progress), "%s.progress", G.out);
+
+    // a stored key is exact when 256^keyBytes * size exceeds every key3
+    // of up to `depth` stones (3^(depth + 6))
+    G.size = next_prime((size_t)1 << G.logSize);
+    G.keyBytes = 1;
+    while (G.keyBytes < 8 &&
+           8.0 * G.keyBytes * log(2.0) + log((double)G.size) <= (G.depth + 6) * log(3.0)) {
+        G.keyBytes++;
+    }
+
+    G.keys   = calloc(G.size, (size_t)G.keyBytes);
+    G.values = calloc(G.size, 1);
+    G.seen   = calloc(G.size / 8 + 1, 1);
+    G.splitPly = G.depth < SPLIT_PLY ? G.depth : SPLIT_PLY;
+    pthread_mutex_init(&G.lock, NULL);
+    if (!G.keys || !G.values || !G.seen) {
+        fprintf(stderr, "book_gen: not enough memory for 2^%d entries\n", G.logSize);
+        return 1;
+    }
+
+    // the engine runs single-threaded per call; we bring the threads
+    setHardBotThreads(1);
+    setHardBotHashMB(G.hashMB);
+    HardBotLimits limits = {0, 0, 0, 1};
+    setHardBotLimits(&limits);
+    initHardBot();
+
+    build_units();
+    G.done = calloc(G.unitCount, 1);
+    if (!G.done) { perror("book_gen"); return 1; }
+    if (resume()) {
+        printf("resuming '%s': %zu of %zu units done\n", G.out, G.doneCount, G.unitCount);
+    }
+
+    printf("depth=%d  entries=%zu  keyBytes=%d  units=%zu  threads=%d\n",
+           G.depth, G.size, G.keyBytes, G.unitCount, G.threads);
+
+    pthread_t workers[MAX_THREADS];
+    int started = 0;
+    for (int i = 0; i < G.threads; i++) {
+        if (pthread_create(&workers[i], NULL, worker, (void *)(intptr_t)i) != 0) break;
+        started++;
+    }
+    if (started == 0) {
+        fprintf(stderr, "book_gen: could not start worker threads\n");
+        return 1;
+    }
+
+    time_t start = time(NULL), lastCheckpoint = start;
+    for (;;) {
+        sleep(1);
+        pthread_mutex_lock(&G.lock);
+        size_t doneCount = G.doneCount;
+        pthread_mutex_unlock(&G.lock);
+        if (doneCount == G.unitCount) break;
+
+        time_t now = time(NULL);
+        if (now - lastCheckpoint >= G.checkpointSec) {
+            checkpoint();
+            lastCheckpoint = now;
+            printf("[%lds] units %zu/%zu  solved %llu  collisions %llu  (checkpoint)\n",
+                   (long)(now - start), doneCount, G.unitCount,
+                   (unsigned long long)atomic_load(&G.solved),
+                   (unsigned long long)atomic_load(&G.collisions));
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    checkpoint();
+    remove(G.progress);
+
+    printf("done in %lds: '%s', %llu positions solved, %llu slot collisions\n",
+           (long)(time(NULL) - start), G.out,
+           (unsigned long long)atomic_load(&G.solved),
+           (unsigned long long)atomic_load(&G.collisions));
+    return 0;
+}
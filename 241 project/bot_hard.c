@@ -9,50 +9,119 @@
 
 #define USE_THREADS 1         /* set to 0 if you can't use pthreads */
 
+/* set to 0 (-DUSE_CPU_DISPATCH=0) for a single portable build; sanitizer
+   builds need it too, since the ifunc resolvers run before the sanitizer
+   runtime is set up and -fsanitize=thread then crashes at startup */
+#ifndef USE_CPU_DISPATCH
+#define USE_CPU_DISPATCH 1
+#endif
+
 #if USE_THREADS
 #include <pthread.h>
 #endif
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* The search kernels (negamax and the solver with the evaluation and
+ * connect-4 code inlined into them, threat ordering, the book key) are
+ * built three times: for Haswell and later (POPCNT, BMI2, AVX2), for
+ * POPCNT only, and for the baseline the rest of the file targets. The
+ * dynamic loader picks one for the running CPU (GCC ifunc), so one
+ * generic binary still gets hardware popcount. */
+#if USE_CPU_DISPATCH && defined(__GNUC__) && !defined(__clang__) && \
+    defined(__x86_64__) && defined(__linux__)
+#define CPU_DISPATCH __attribute__((target_clones("arch=haswell", "popcnt", "default")))
+#else
+#define CPU_DISPATCH
+#endif
 
 /* ===============================================================
    Strong Connect-4 bot (bitboards, multithreaded) + Pascal book
    ---------------------------------------------------------------
    - Bitboard representation: (position, mask), 7 bits/column
-   - Root opening book from Pascal Pons 7x6.book
+   - Opening book from Pascal Pons 7x6.book, at the root and inside
+     the search for every node within book depth
        * Real binary format with header + key/value arrays
        * Uses Pascal's symmetric base-3 key3() over (position, mask)
        * Book depth from file header (for 7x6.book: depth = 14)
-   - Alpha-beta + transposition table with bounds
-   - Iterative deepening with ~10s time limit
-   - TT-based move ordering + center-first fallback
+   - Alpha-beta + shared lock-free transposition table with bounds,
+     aged by search generation so it survives from move to move
+   - Iterative deepening under wall-clock / node / depth limits
+     (default ~10s per move), polled every few thousand nodes
+   - Non-losing move generation from threat bitboards; moves ordered
+     by TT hint, then threats created, then center-first
    - Aspiration windows at root
-   - Late move reduction (LMR) inside negamax
-   - Root-level multithreading: one thread per playable column
+   - Exact solver (null-window bisection on Pascal scores) once few
+     enough cells are left
+   - Principal variation search (null-window scouts) with late move
+     reduction (LMR) inside negamax
+   - Multithreading: Lazy SMP (all threads search the root and share
+     the TT) or young brothers wait (idle threads steal the remaining
+     moves of nodes whose first move is done), both run on a
+     persistent worker pool created once by initHardBot()
    =============================================================== */
 
 #define WIN_SCORE        1000000
 #define LOSS_SCORE      -1000000
 #define INF_SCORE        2000000000
+#define PROVEN_WIN       (WIN_SCORE - 1000)   /* above: a forced win */
 
-/* Safety margin under 10s */
+/* Safety margin under 10s (wall clock) */
 #define TIME_LIMIT_SEC   9.8
 
-/* Transposition table: 2^22 ~ 4M entries (~64MB).
- * If that's too big on your machine, drop back to 21. */
-#define TT_BITS   22
-#define TT_SIZE   (1u << TT_BITS)
-#define TT_MASK   (TT_SIZE - 1)
+/* Each thread polls the deadline and node budget once per this many
+   nodes (power of two); in between it only reads the stop flag. */
+#define POLL_NODES       2048
+
+/* Transposition table: 8-byte entries in 64-byte buckets of TT_WAYS
+ * entries, mapped on first use. Default 64MB (8M entries); change it
+ * at runtime with setHardBotHashMB(). The size is rounded down to a
+ * power of two; from 8MB up (2^17 buckets) partial keys are exact. */
+#define TT_WAYS        8
+#define TT_DEFAULT_MB  64
+#define TT_HUGE_PAGE   (2u << 20)
+
+/* Solver mode: with this many empty cells or fewer the bot proves the
+ * exact game value instead of running the heuristic search. Change it
+ * at runtime with setHardBotSolverEmpties() (0 = never). The solver
+ * gets SOLVER_BUDGET_SHARE of the time and node limits; if it has not
+ * finished by then the heuristic search runs on the rest. */
+#define SOLVER_EMPTIES       20
+#define SOLVER_BUDGET_SHARE  0.5
 
 /* LMR settings (very standard, quite safe) */
 #define LMR_MIN_DEPTH    5   /* only reduce when depth >= this */
 #define LMR_MOVE_INDEX   3   /* reduce from 4th move onwards */
 #define LMR_REDUCTION    1   /* reduce by 1 ply */
 
-/* Threads: at most 7 columns anyway */
-#if USE_THREADS
-#define NUM_THREADS 7
-#else
-#define NUM_THREADS 1
-#endif
+/* Quiescence: at the horizon, keep playing while the side to move has
+ * exactly one non-losing move (a forced block), up to this many plies. */
+#define QS_MAX_PLIES     8
+
+/* Dead-line test (can_still_win) from this many stones on; before that
+ * every side still has open fours and the test is wasted work. */
+#define DEAD_MIN_MOVES   16
+
+/* Parallel search, chosen at runtime with setHardBotParallelMode():
+ * HARD_BOT_LAZY_SMP (default) - every thread runs its own iterative
+ * deepening on the root and they cooperate only through the shared
+ * TT; helpers skip depths in per-thread patterns (skips_depth) so
+ * they fill the table ahead of the main thread.
+ * HARD_BOT_YBWC - young brothers wait: a single search whose nodes
+ * share their remaining moves with idle threads once the first move
+ * is searched (see "Split points"). */
+#define SMP_MAX_THREADS  64
+
+/* YBWC: only nodes with at least this much depth left are split, and
+ * a thread keeps at most SPLIT_MAX_NESTED of its split points open */
+#define SPLIT_MIN_DEPTH  6
+#define SPLIT_MAX_NESTED 16
+
+/* worker pool job queue; jobs beyond this run inline in the caller */
+#define POOL_QUEUE_SIZE  128
 
 /* -------- Pascal book config (binary file) -------- */
 #define PASCAL_BOOK_FILE "7x6.book"  /* must be in same directory as executable */
@@ -67,9 +136,6 @@ static int pascalBookLoaded = 0;
 static void pascal_book_load(const char *filename);
 
 
-
-void initHardBot();
-
 /* ===============================================================
    Your engine position + TT
    =============================================================== */
@@ -78,31 +144,117 @@ typedef struct {
     uint64_t position;   /* stones of player to move in this node */
     uint64_t mask;       /* stones of both players                */
     int      moves;      /* number of stones on board             */
+    int      eval;       /* center + pattern terms of evaluate(),
+                            side to move's view; kept by play_move */
+    uint64_t mirrorPosition;   /* the same two bitboards with the    */
+    uint64_t mirrorMask;       /* columns in reverse order           */
+    uint64_t key;        /* TT key of the canonical orientation   */
+    int      mirrored;   /* 1 if the key is the mirror's: TT moves
+                            are stored as COLS - 1 - col          */
 } Position;
 
+/* One TT slot: a single 64-bit word (see tt_pack), read and written
+ * atomically, so threads share the table without locks and an entry
+ * can never be torn. 0 means empty. */
+typedef _Atomic uint64_t TTEntry;
+
+/* One cache line. Ways 0..TT_WAYS-2 are depth-preferred, the last way
+ * is always-replace (it takes whatever the others refuse). */
 typedef struct {
-    uint64_t key;
-    int32_t  value;
-    int16_t  depth;
-    int8_t   flag;       /* 0 exact, 1 lower bound, 2 upper bound */
-    int8_t   bestMove;   /* 0..6 or -1                            */
-} TTEntry;
+    TTEntry e[TT_WAYS];
+} __attribute__((aligned(64))) TTBucket;
 
-static TTEntry tt[TT_SIZE];
+static TTBucket *tt = NULL;         /* NULL until the first search  */
+static size_t    ttBytes = 0;        /* size of the mapping          */
+static unsigned  ttBucketBits = 0;
+static size_t    ttRequestedMB = TT_DEFAULT_MB;
+
+/* used when mmap fails: one bucket still gives a (tiny) working TT */
+static TTBucket  ttFallback;
 
 /* precomputed masks for each column */
 static uint64_t bottomMask[COLS];
 static uint64_t columnMask[COLS];
 static uint64_t topMask[COLS];
+static uint64_t bottomRow;   /* bottom cell of every column */
+static uint64_t boardMask;   /* every playable cell         */
+
+/* four bitboards at once (GCC vector extension: AVX2 in the Haswell
+   build, two SSE2 halves otherwise); columns 0-3 and 4-6 of
+   columnMask, the last lane empty */
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+static u64x4 columnMaskX4[2];
 
 /* center-first base move ordering (fallback when no TT hint) */
 static const int moveOrder[COLS] = {3, 2, 4, 1, 5, 0, 6};
 
-/* timing globals */
-static clock_t startTime;
-static volatile int timeExpired = 0;
+/* search limits + timing globals */
+static HardBotLimits g_limits = { TIME_LIMIT_SEC, 0, 0, 0 };
+static struct timespec startTime;
+static atomic_int stopSearch;             /* set once any limit is hit */
+static atomic_uint g_stopRequests;        /* stopHardBot() calls so far */
+static unsigned g_moveStopRequests;       /* ... when this move began   */
+static double g_budgetShare = 1.0;        /* share of the limits in use */
+static atomic_llong g_rootWin;            /* proven root win: score << 8
+                                             | column, 0 = none yet     */
+static atomic_uint_fast64_t totalNodes;   /* flushed every POLL_NODES  */
 static int lastCompletedDepth = 0;
-static int lastSelectiveDepth = 0;
+static int g_solverEmpties = SOLVER_EMPTIES;
+
+/* Move ordering memory, per thread and cleared for every move:
+ * the last two columns that caused a beta cut at each ply (killers),
+ * and a history score per side and cell, raised by depth^2 on every
+ * cut (halved for that side once it passes HISTORY_MAX). Below the
+ * threat count, a move's order is its center-first rank times
+ * ORDER_CENTER_STEP plus its history plus ORDER_KILLER_BONUS for a
+ * killer: center-first stays a strong prior that history must
+ * consistently beat (heavier killer/history weights cost nodes). */
+#define KILLER_PLIES        64
+#define HISTORY_MAX         (1 << 20)
+#define ORDER_CENTER_STEP   (1 << 16)
+#define ORDER_KILLER_BONUS  (1 << 14)
+
+/* per-thread search state, indexed by thread_id */
+typedef struct {
+    uint64_t nodes;          /* nodes visited for this move   */
+    unsigned unpolled;       /* nodes since the last poll     */
+    int      selDepth;       /* deepest ply reached           */
+    uint64_t bookProbes;     /* in-search opening book probes */
+    uint64_t bookHits;
+    int8_t   killers[KILLER_PLIES][2];   /* -1 = empty            */
+    int      history[2][COLS * 7];       /* [side][bit index]     */
+    struct SplitPoint *split;    /* YBWC: split point worked on  */
+    /* an offline solve (solveHardBotPosition) runs on its own clock,
+       node count and stop flag, so concurrent callers stay independent */
+    int      solo;
+    int      stopped;
+    unsigned stopRequests;       /* g_stopRequests when it began  */
+    struct timespec start;
+} __attribute__((aligned(64))) SearchThread;
+
+#if USE_THREADS
+/* A node whose remaining moves are open to other threads. It lives on
+ * its owner's stack until every thread that joined it has left. */
+typedef struct SplitPoint {
+    pthread_mutex_t    lock;       /* guards next..bestMove          */
+    const Position    *pos;
+    const Position    *children;   /* the owner's ordered children  */
+    const int         *cols;
+    int                count;
+    int                depth;
+    int                beta;
+    int                ply;
+    struct SplitPoint *parent;     /* split point the owner is under */
+    atomic_int         cutoff;     /* a move reached beta: stop      */
+    int                next;       /* next child to hand out         */
+    int                joined;     /* helpers still working on it    */
+    int                alpha;
+    int                bestVal;
+    int                bestMove;
+} SplitPoint;
+#endif
+
+static SearchThread g_threads[SMP_MAX_THREADS];
 
 /* ===============================================================
    Pascal-compatible position + opening book structures
@@ -115,8 +267,10 @@ typedef struct {
 } PascalPos;
 
 typedef struct {
-    uint8_t *keys;    /* partial keys array (size * partial_key_bytes) */
-    uint8_t *values;  /* value bytes (size * 1)                         */
+    const uint8_t *keys;    /* partial keys array (size * partial_key_bytes) */
+    const uint8_t *values;  /* value bytes (size * 1)                         */
+    const uint8_t *map;     /* read-only shared mapping of the whole file     */
+    size_t   mapBytes;
     size_t   size;    /* number of stored elements (prime, ~2^24)       */
     int      partial_key_bytes; /* 1 in Pascal 7x6.book                  */
     int      depth;             /* max nbMoves stored                    */
@@ -143,6 +297,7 @@ static inline void pascal_partialKey3(uint64_t *key, const PascalPos *P, int col
     *key *= 3ULL;
 }
 
+CPU_DISPATCH
 static uint64_t pascal_key3(const PascalPos *P) {
     uint64_t key_forward = 0;
     uint64_t key_reverse = 0;
@@ -165,27 +320,34 @@ static uint64_t pascal_key3(const PascalPos *P) {
 }
 
 /* ---------------------------------------------------------------
-   Load Pascal 7x6.book (binary) into memory
+   Validate the 7x6.book header against the file size (reads only
+   the 6 header bytes; the payload is never touched)
    ------------------------------------------------------------ */
 
-static void pascal_book_load(const char *filename) {
-    if (g_book.loaded) return;      /* only try once */
-    g_book.loaded = 1;
-
-    FILE *f = fopen(filename, "rb");
-    if (!f) {
-        fprintf(stderr, "[HARD BOT] opening book '%s' not found, continuing without book.\n",
-                filename);
-        g_book.ok = 0;
-        return;
+/* Pascal sizes the book table as the first prime >= 2^log_size */
+static size_t next_prime(size_t n) {
+    for (;; ++n) {
+        int prime = (n >= 2);
+        for (size_t d = 2; prime && d * d <= n; ++d) {
+            if (n % d == 0) prime = 0;
+        }
+        if (prime) return n;
     }
+}
 
+typedef struct {
+    int    depth;
+    int    keyBytes;
+    int    logSize;
+    size_t size;       /* number of entries   */
+    size_t fileBytes;
+} PascalBookHeader;
+
+static int pascal_book_check(int fd, const char *filename, PascalBookHeader *out) {
     unsigned char header[6];
-    if (fread(header, 1, 6, f) != 6) {
+    if (pread(fd, header, 6, 0) != 6) {
         fprintf(stderr, "[HARD BOT] failed to read header from '%s'.\n", filename);
-        fclose(f);
-        g_book.ok = 0;
-        return;
+        return 0;
     }
 
     int width   = header[0];
@@ -193,105 +355,118 @@ static void pascal_book_load(const char *filename) {
     int depth   = header[2];
     int keyBytes   = header[3];
     int valueBytes = header[4];
-    int log_size   = header[5]; /* unused, but kept for completeness */
+    int log_size   = header[5]; /* table holds next_prime(2^log_size) entries */
 
     if (width != PASCAL_WIDTH || height != PASCAL_HEIGHT) {
         fprintf(stderr,
                 "[HARD BOT] book '%s' has wrong board size (got %d x %d, expected %d x %d).\n",
                 filename, width, height, PASCAL_WIDTH, PASCAL_HEIGHT);
-        fclose(f);
-        g_book.ok = 0;
-        return;
+        return 0;
     }
     if (valueBytes != 1) {
         fprintf(stderr,
                 "[HARD BOT] book '%s' has unsupported value size %d (expected 1).\n",
                 filename, valueBytes);
-        fclose(f);
-        g_book.ok = 0;
-        return;
+        return 0;
     }
     if (keyBytes < 1 || keyBytes > 8) {
         fprintf(stderr,
                 "[HARD BOT] book '%s' has invalid key size %d.\n",
                 filename, keyBytes);
-        fclose(f);
-        g_book.ok = 0;
-        return;
+        return 0;
+    }
+    if (log_size < 1 || log_size > 40) {
+        fprintf(stderr,
+                "[HARD BOT] book '%s' has invalid log size %d.\n",
+                filename, log_size);
+        return 0;
     }
 
     /* compute table size from file size */
-    if (fseek(f, 0, SEEK_END) != 0) {
-        fprintf(stderr, "[HARD BOT] fseek failed on '%s'.\n", filename);
-        fclose(f);
-        g_book.ok = 0;
-        return;
-    }
-    long fsize = ftell(f);
-    if (fsize < 0) {
-        fprintf(stderr, "[HARD BOT] ftell failed on '%s'.\n", filename);
-        fclose(f);
-        g_book.ok = 0;
-        return;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) {
+        fprintf(stderr, "[HARD BOT] fstat failed on '%s'.\n", filename);
+        return 0;
     }
-    long payload = fsize - 6L;
-    long perEntry = keyBytes + valueBytes;
-    if (payload <= 0 || payload % perEntry != 0) {
+    long long payload = (long long)sb.st_size - 6LL;
+    long long perEntry = keyBytes + valueBytes;
+    long long expected = (long long)next_prime((size_t)1 << log_size);
+    if (payload <= 0 || payload != expected * perEntry) {
         fprintf(stderr,
-                "[HARD BOT] book '%s' payload size mismatch (payload=%ld, perEntry=%ld).\n",
-                filename, payload, perEntry);
-        fclose(f);
-        g_book.ok = 0;
-        return;
+                "[HARD BOT] book '%s' payload size mismatch (payload=%lld, expected %lld x %lld).\n",
+                filename, payload, expected, perEntry);
+        return 0;
     }
-    size_t size = (size_t)(payload / perEntry);
 
-    if (fseek(f, 6L, SEEK_SET) != 0) {
-        fprintf(stderr, "[HARD BOT] fseek data failed on '%s'.\n", filename);
-        fclose(f);
-        g_book.ok = 0;
+    out->depth     = depth;
+    out->keyBytes  = keyBytes;
+    out->logSize   = log_size;
+    out->size      = (size_t)(payload / perEntry);
+    out->fileBytes = (size_t)sb.st_size;
+    return 1;
+}
+
+/* ---------------------------------------------------------------
+   Map Pascal 7x6.book (binary) read-only and shared: every bot
+   process on the host uses the same page-cache copy, and nothing
+   is read until a probe touches it
+   ------------------------------------------------------------ */
+
+static void pascal_book_load(const char *filename) {
+    if (g_book.loaded) return;      /* only try once */
+    g_book.loaded = 1;
+    g_book.ok = 0;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[HARD BOT] opening book '%s' not found, continuing without book.\n",
+                filename);
         return;
     }
 
-    uint8_t *keys = (uint8_t*)malloc(size * keyBytes);
-    uint8_t *vals = (uint8_t*)malloc(size * valueBytes);
-    if (!keys || !vals) {
-        fprintf(stderr, "[HARD BOT] memory alloc failed for book '%s'.\n", filename);
-        free(keys);
-        free(vals);
-        fclose(f);
-        g_book.ok = 0;
+    PascalBookHeader hdr;
+    if (!pascal_book_check(fd, filename, &hdr)) {
+        close(fd);
         return;
     }
 
-    if (fread(keys, keyBytes, size, f) != size ||
-        fread(vals, valueBytes, size, f) != size) {
-        fprintf(stderr, "[HARD BOT] failed to read key/value arrays from '%s'.\n",
-                filename);
-        free(keys);
-        free(vals);
-        fclose(f);
-        g_book.ok = 0;
+    void *map = mmap(NULL, hdr.fileBytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);                      /* the mapping keeps the file alive */
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "[HARD BOT] mmap failed for book '%s'.\n", filename);
         return;
     }
+#ifdef MADV_RANDOM
+    madvise(map, hdr.fileBytes, MADV_RANDOM);   /* probes are scattered */
+#endif
 
-    fclose(f);
-
-    g_book.keys = keys;
-    g_book.values = vals;
-    g_book.size = size;
-    g_book.partial_key_bytes = keyBytes;
-    g_book.depth = depth;
+    g_book.map = map;
+    g_book.mapBytes = hdr.fileBytes;
+    g_book.keys = (const uint8_t *)map + 6;
+    g_book.values = g_book.keys + hdr.size * (size_t)hdr.keyBytes;
+    g_book.size = hdr.size;
+    g_book.partial_key_bytes = hdr.keyBytes;
+    g_book.depth = hdr.depth;
     g_book.ok = 1;
 
     fprintf(stderr,
-            "[HARD BOT] Pascal 7x6.book loaded: size=%zu, depth=%d, keyBytes=%d, log_size=%d\n",
-            g_book.size, g_book.depth, g_book.partial_key_bytes, log_size);
-}
-void initHardBot() {
-    /* nothing to initialize here yet */
+            "[HARD BOT] Pascal 7x6.book mapped: size=%zu, depth=%d, keyBytes=%d, log_size=%d\n",
+            g_book.size, g_book.depth, g_book.partial_key_bytes, hdr.logSize);
 }
 
+int validateHardBotBook(const char *filename) {
+    if (!filename) filename = PASCAL_BOOK_FILE;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[HARD BOT] opening book '%s' not found.\n", filename);
+        return 0;
+    }
+    PascalBookHeader hdr;
+    int ok = pascal_book_check(fd, filename, &hdr);
+    close(fd);
+    return ok;
+}
 
 /* ---------------------------------------------------------------
    Query Pascal book for a position (score for player to move)
@@ -329,6 +504,42 @@ static int pascal_book_score(const PascalPos *P, int *outScore) {
     return 1;
 }
 
+/* ---------------------------------------------------------------
+   Pascal score <-> engine score for the side to move. A Pascal score
+   s > 0 means the side to move wins and the winning stone is number
+   43 - 2s (44 - 2s when it is the second player); the engine scores
+   that as WIN_SCORE - (stones on board at the win). Losses mirror it.
+   Both maps are monotonic, so bounds convert too.
+   ------------------------------------------------------------ */
+
+static inline int pascal_to_engine(int s, int moves) {
+    int odd = moves & 1;
+    if (s > 0) return WIN_SCORE  - (ROWS * COLS + 1 - 2 * s + odd);
+    if (s < 0) return LOSS_SCORE + (ROWS * COLS + 1 + 2 * s + !odd);
+    return 0;
+}
+
+static inline int engine_to_pascal(int v, int moves) {
+    int odd = moves & 1;
+    if (v > 0) return (ROWS * COLS + 1 + odd - (WIN_SCORE - v)) / 2;
+    if (v < 0) return ((v - LOSS_SCORE) - (ROWS * COLS + 1) - !odd) / 2;
+    return 0;
+}
+
+/* book score in the engine's scale */
+static int book_engine_score(const Position *p, int *outScore) {
+    PascalPos P;
+    P.current_position = p->position;
+    P.mask             = p->mask;
+    P.moves            = (unsigned int)p->moves;
+
+    int s;
+    if (!pascal_book_score(&P, &s)) return 0;
+
+    *outScore = pascal_to_engine(s, p->moves);
+    return 1;
+}
+
 /* ---------------------------------------------------------------
    Try to get a perfect root move from Pascal book.
    Returns 1 if book fully covers all legal moves and outMove is set.
@@ -405,16 +616,101 @@ static int try_opening_book(const Position *root, int *outMove) {
    =============================================================== */
 
 static void init_masks(void) {
+    bottomRow = 0ULL;
+    boardMask = 0ULL;
     for (int c = 0; c < COLS; ++c) {
         bottomMask[c] = 1ULL << (c * 7);
         columnMask[c] = ((1ULL << ROWS) - 1ULL) << (c * 7);
         topMask[c]    = 1ULL << (c * 7 + (ROWS - 1));
+        bottomRow    |= bottomMask[c];
+        boardMask    |= columnMask[c];
+        columnMaskX4[c / 4][c % 4] = columnMask[c];
+    }
+}
+
+static double elapsed_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec)
+         + (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static double elapsed_sec(void) {
+    return elapsed_since(&startTime);
+}
+
+static inline int search_stopped(void) {
+    return atomic_load_explicit(&stopSearch, memory_order_relaxed);
+}
+
+static inline void stop_search(void) {
+    atomic_store_explicit(&stopSearch, 1, memory_order_relaxed);
+}
+
+/* A root move is a forced win: keep it (the fastest one if several
+   threads get there) and stop every thread, since nothing any of them
+   is still searching can change the move. */
+static void publish_root_win(int col, int score) {
+    long long packed = ((long long)score << 8) | col;
+    long long cur = atomic_load(&g_rootWin);
+    while (packed > cur && !atomic_compare_exchange_weak(&g_rootWin, &cur, packed)) {
+    }
+    stop_search();
+}
+
+/* check time and node limits; sets the stop flag when one is hit */
+static int limits_reached(void) {
+    if (search_stopped()) return 1;
+    if (atomic_load_explicit(&g_stopRequests, memory_order_relaxed) != g_moveStopRequests) {
+        stop_search();   /* stopHardBot(), even if a restart cleared it */
+        return 1;
+    }
+    if (g_limits.infinite) return 0;
+
+    if ((g_limits.nodes > 0 &&
+         atomic_load_explicit(&totalNodes, memory_order_relaxed) >=
+             (uint64_t)(g_limits.nodes * g_budgetShare)) ||
+        (g_limits.timeSec > 0 && elapsed_sec() >= g_limits.timeSec * g_budgetShare)) {
+        stop_search();
+        return 1;
+    }
+    return 0;
+}
+
+/* the same for an offline solve, on the thread's own clock and nodes;
+   a stopHardBot() issued since the solve began ends it as well */
+static int solo_limits_reached(SearchThread *t) {
+    if (t->stopped) return 1;
+    if (atomic_load_explicit(&g_stopRequests, memory_order_relaxed) != t->stopRequests ||
+        (!g_limits.infinite &&
+         ((g_limits.nodes > 0 && t->nodes >= g_limits.nodes) ||
+          (g_limits.timeSec > 0 && elapsed_since(&t->start) >= g_limits.timeSec)))) {
+        t->stopped = 1;
     }
+    return t->stopped;
 }
 
-static inline int time_up(void) {
-    double elapsed = (double)(clock() - startTime) / CLOCKS_PER_SEC;
-    return elapsed >= TIME_LIMIT_SEC;
+/* the stop flag as one thread sees it: with YBWC, a beta cut at any
+   split point the thread is working under also ends its search */
+static inline int search_aborted(const SearchThread *t) {
+    if (t->solo) return t->stopped;
+#if USE_THREADS
+    for (const SplitPoint *sp = t->split; sp; sp = sp->parent) {
+        if (atomic_load_explicit(&sp->cutoff, memory_order_relaxed)) return 1;
+    }
+#endif
+    return search_stopped();
+}
+
+/* count a node; only every POLL_NODES-th call looks at the clock */
+static inline int node_tick(SearchThread *t) {
+    t->nodes++;
+    if (++t->unpolled >= POLL_NODES) {
+        atomic_fetch_add_explicit(&totalNodes, t->unpolled, memory_order_relaxed);
+        t->unpolled = 0;
+        if (t->solo ? solo_limits_reached(t) : limits_reached()) return 1;
+    }
+    return search_aborted(t);
 }
 
 /* opponent stones = mask XOR position */
@@ -427,13 +723,70 @@ static inline int can_play(const Position *p, int col) {
     return (p->mask & topMask[col]) == 0ULL;
 }
 
+/* Position key: position + mask is a unique 49-bit encoding of the
+ * board (Pascal Pons' key). Multiplying by an odd constant modulo 2^49
+ * is a bijection, so the mixed key still identifies the position: the
+ * top ttBucketBits pick the bucket and the low 32 bits are stored in
+ * the entry. Together they cover all 49 bits, so a matching entry is
+ * the same position, not just a likely one. play_move computes it once
+ * per node and Position carries it (XOR-ed Zobrist keys would be
+ * cheaper to update but lose that exactness).
+ *
+ * A board and its left-right mirror share one key: it is taken from
+ * whichever orientation has the smaller position + mask (no column
+ * carries into the next, so that is a per-column encoding as well). */
+#define KEY_BITS  49
+#define KEY_MASK  ((1ULL << KEY_BITS) - 1ULL)
+
+static inline uint64_t position_key(uint64_t position, uint64_t mask) {
+    return ((position + mask) * 0x9E3779B185EBCA87ULL) & KEY_MASK;
+}
+
+/* pick the canonical orientation and set key + mirrored */
+static inline void update_key(Position *p) {
+    uint64_t direct = p->position + p->mask;
+    uint64_t mirror = p->mirrorPosition + p->mirrorMask;
+    p->mirrored = mirror < direct;
+    p->key = p->mirrored ? position_key(p->mirrorPosition, p->mirrorMask)
+                         : position_key(p->position, p->mask);
+}
+
+/* weight of a stone in the center column, and of the 2- and
+   3-in-a-row patterns counted by pattern_score() */
+#define EVAL_CENTER    6
+#define EVAL_PAIR      2
+#define EVAL_TRIPLE    5
+
+/* how much pattern_score(b) grows when the stone `m` joins b: only
+   the pairs and triples through that cell change */
+static inline int pattern_gain(uint64_t b, uint64_t m) {
+    static const int dirs[4] = {7, 1, 6, 8};
+    int s = 0;
+    for (int i = 0; i < 4; ++i) {
+        int d = dirs[i];
+        int lo1 = (b & (m >> d)) != 0, lo2 = (b & (m >> (2 * d))) != 0;
+        int hi1 = (b & (m << d)) != 0, hi2 = (b & (m << (2 * d))) != 0;
+        s += (lo1 + hi1) * EVAL_PAIR;
+        s += ((lo1 & lo2) + (lo1 & hi1) + (hi1 & hi2)) * EVAL_TRIPLE;
+    }
+    return s;
+}
+
 /* play a move in column col, using Pascal-style position/mask flip */
 static inline void play_move(Position *p, int col) {
     uint64_t m = p->mask;
     uint64_t move = (m + bottomMask[col]) & columnMask[col];
+    int gain = pattern_gain(p->position, move) + ((col == 3) ? EVAL_CENTER : 0);
+    p->eval = -(p->eval + gain);   /* the other side is to move now */
     p->position ^= m;
     p->mask = m | move;
     p->moves++;
+
+    int mcol = COLS - 1 - col;
+    uint64_t mm = p->mirrorMask;
+    p->mirrorPosition ^= mm;
+    p->mirrorMask = mm | ((mm + bottomMask[mcol]) & columnMask[mcol]);
+    update_key(p);
 }
 
 /* detect a connect-4 in bitboard bb */
@@ -459,6 +812,150 @@ static int has_connect4(uint64_t bb) {
     return 0;
 }
 
+/* could the stones in `bb` still make a four if every empty cell went
+   to them? When not, that side can do no better than a draw. */
+static inline int can_still_win(uint64_t bb, uint64_t mask) {
+    return has_connect4(bb | (boardMask & ~mask));
+}
+
+/* empty cells that would complete a four for the stones in `bb`
+   (Pascal Pons' compute_winning_position) */
+static uint64_t winning_cells(uint64_t bb, uint64_t mask) {
+    /* vertical */
+    uint64_t r = (bb << 1) & (bb << 2) & (bb << 3);
+    uint64_t p;
+
+    /* horizontal (shift 7) */
+    p = (bb << 7) & (bb << 14);
+    r |= p & (bb << 21);
+    r |= p & (bb >> 7);
+    p = (bb >> 7) & (bb >> 14);
+    r |= p & (bb << 7);
+    r |= p & (bb >> 21);
+
+    /* diagonal \ (shift 6) */
+    p = (bb << 6) & (bb << 12);
+    r |= p & (bb << 18);
+    r |= p & (bb >> 6);
+    p = (bb >> 6) & (bb >> 12);
+    r |= p & (bb << 6);
+    r |= p & (bb >> 18);
+
+    /* diagonal / (shift 8) */
+    p = (bb << 8) & (bb << 16);
+    r |= p & (bb << 24);
+    r |= p & (bb >> 8);
+    p = (bb >> 8) & (bb >> 16);
+    r |= p & (bb << 8);
+    r |= p & (bb >> 24);
+
+    return r & (boardMask ^ mask);
+}
+
+/* cells where the next stone of each column would land */
+static inline uint64_t playable_cells(uint64_t mask) {
+    return (mask + bottomRow) & boardMask;
+}
+
+/* the same for four boards, `empty` being their empty cells (vectors
+   go by pointer: passing them by value is not ABI-stable without AVX) */
+static inline void winning_cells_x4(const u64x4 *board, const u64x4 *empty,
+                                    u64x4 *out) {
+    u64x4 bb = *board;
+    u64x4 r = (bb << 1) & (bb << 2) & (bb << 3);
+    u64x4 p;
+
+    p = (bb << 7) & (bb << 14);
+    r |= p & (bb << 21);
+    r |= p & (bb >> 7);
+    p = (bb >> 7) & (bb >> 14);
+    r |= p & (bb << 7);
+    r |= p & (bb >> 21);
+
+    p = (bb << 6) & (bb << 12);
+    r |= p & (bb << 18);
+    r |= p & (bb >> 6);
+    p = (bb >> 6) & (bb >> 12);
+    r |= p & (bb << 6);
+    r |= p & (bb >> 18);
+
+    p = (bb << 8) & (bb << 16);
+    r |= p & (bb << 24);
+    r |= p & (bb >> 8);
+    p = (bb >> 8) & (bb >> 16);
+    r |= p & (bb << 8);
+    r |= p & (bb >> 24);
+
+    *out = r & *empty;
+}
+
+/* playable cells that don't let the opponent (whose winning cells are
+   oppWin) win right away; 0 if every move loses. Assumes the side to
+   move cannot win immediately. */
+static inline uint64_t non_losing_cells(uint64_t mask, uint64_t oppWin) {
+    uint64_t moves  = playable_cells(mask);
+    uint64_t forced = moves & oppWin;
+    if (forced) {
+        if (forced & (forced - 1)) return 0;   /* two threats: lost */
+        moves = forced;
+    }
+    return moves & ~(oppWin >> 1);             /* don't play under a threat */
+}
+
+static inline uint64_t non_losing_moves(const Position *p) {
+    return non_losing_cells(p->mask, winning_cells(opponent_bb(p), p->mask));
+}
+
+/* Expands every move in `next` in one pass: threats[col] = winning
+   cells of the side to move after it plays in col (what the opponent
+   must answer in that child). Columns not in `next` are left unset. */
+CPU_DISPATCH
+static void child_threats(const Position *p, uint64_t next, uint64_t threats[COLS]) {
+    uint64_t moves = playable_cells(p->mask) & next;
+    u64x4 out[2];
+    for (int h = 0; h < 2; ++h) {
+        u64x4 move  = columnMaskX4[h] & moves;
+        u64x4 board = move | p->position;
+        u64x4 empty = boardMask ^ (move | p->mask);
+        winning_cells_x4(&board, &empty, &out[h]);
+    }
+    memcpy(threats, out, COLS * sizeof(uint64_t));
+}
+
+/* columns of the moves in `next`: ttMove first, then by the number of
+   threats each move creates (from child_threats), then center rank,
+   history and killers of thread `st` at `ply` (st may be NULL), ties
+   center-first. Returns the count. */
+CPU_DISPATCH
+static int order_moves(const Position *p, uint64_t next, const uint64_t threats[COLS],
+                       int ttMove, const SearchThread *st, int ply, int cols[COLS]) {
+    int scores[COLS], count = 0;
+    for (int i = 0; i < COLS; ++i) {
+        int col = moveOrder[i];
+        uint64_t move = next & columnMask[col];
+        if (!move) continue;
+        int sc = __builtin_popcountll(threats[col]) << 24;
+        if (st) {
+            sc += (COLS - i) * ORDER_CENTER_STEP;
+            sc += st->history[p->moves & 1][__builtin_ctzll(move)];
+            if (ply < KILLER_PLIES &&
+                (st->killers[ply][0] == col || st->killers[ply][1] == col)) {
+                sc += ORDER_KILLER_BONUS;
+            }
+        }
+        if (col == ttMove) sc = INT_MAX;
+        int j = count++;
+        while (j > 0 && scores[j - 1] < sc) {
+            cols[j] = cols[j - 1];
+            scores[j] = scores[j - 1];
+            j--;
+        }
+        cols[j] = col;
+        scores[j] = sc;
+    }
+    return count;
+}
+
 /* count 2- and 3-in-a-row patterns in all directions for a given bitboard */
 static int pattern_score(uint64_t b) {
     int s = 0;
@@ -466,33 +963,45 @@ static int pattern_score(uint64_t b) {
 
     /* horizontal (shift 7) */
     m = b & (b >> 7);                     /* at least 2 in a row */
-    s += __builtin_popcountll(m) * 2;
+    s += __builtin_popcountll(m) * EVAL_PAIR;
     m &= (b >> 14);                       /* now 3 in a row */
-    s += __builtin_popcountll(m) * 5;
+    s += __builtin_popcountll(m) * EVAL_TRIPLE;
 
     /* vertical (shift 1) */
     m = b & (b >> 1);
-    s += __builtin_popcountll(m) * 2;
+    s += __builtin_popcountll(m) * EVAL_PAIR;
     m &= (b >> 2);
-    s += __builtin_popcountll(m) * 5;
+    s += __builtin_popcountll(m) * EVAL_TRIPLE;
 
     /* diagonal / (shift 6) */
     m = b & (b >> 6);
-    s += __builtin_popcountll(m) * 2;
+    s += __builtin_popcountll(m) * EVAL_PAIR;
     m &= (b >> 12);
-    s += __builtin_popcountll(m) * 5;
+    s += __builtin_popcountll(m) * EVAL_TRIPLE;
 
     /* diagonal \ (shift 8) */
     m = b & (b >> 8);
-    s += __builtin_popcountll(m) * 2;
+    s += __builtin_popcountll(m) * EVAL_PAIR;
     m &= (b >> 16);
-    s += __builtin_popcountll(m) * 5;
+    s += __builtin_popcountll(m) * EVAL_TRIPLE;
 
     return s;
 }
 
-/* improved evaluation: center + patterns + small tempo bias */
-static int evaluate(const Position *p) {
+/* the fields play_move maintains (evaluation and TT key) from scratch,
+   for a position built from a board */
+static void init_position(Position *p) {
+    p->mirrorPosition = 0ULL;
+    p->mirrorMask     = 0ULL;
+    for (int c = 0; c < COLS; ++c) {
+        int shift = 7 * (COLS - 1 - 2 * c);   /* column c -> COLS - 1 - c */
+        uint64_t pc = p->position & columnMask[c];
+        uint64_t mc = p->mask & columnMask[c];
+        p->mirrorPosition |= (shift >= 0) ? pc << shift : pc >> -shift;
+        p->mirrorMask     |= (shift >= 0) ? mc << shift : mc >> -shift;
+    }
+    update_key(p);
+
     uint64_t cur = p->position;
     uint64_t opp = opponent_bb(p);
 
@@ -501,12 +1010,14 @@ static int evaluate(const Position *p) {
     int centerScore = (int)__builtin_popcountll(cur & center)
                     - (int)__builtin_popcountll(opp & center);
 
-    int score = centerScore * 6;  /* slightly stronger weight */
-
     /* pattern-based score (2- and 3-in-a-row) */
-    int curPatterns = pattern_score(cur);
-    int oppPatterns = pattern_score(opp);
-    score += (curPatterns - oppPatterns);
+    p->eval = centerScore * EVAL_CENTER
+            + pattern_score(cur) - pattern_score(opp);
+}
+
+/* improved evaluation: center + patterns + small tempo bias */
+static int evaluate(const Position *p) {
+    int score = p->eval;   /* center + patterns, kept by play_move */
 
     /* early-game anti-overstack in center:
        if both players are contesting the center and we already have
@@ -515,8 +1026,8 @@ static int evaluate(const Position *p) {
        especially as second player, to explore side threats instead
        of blindly building a tall center pillar. */
     if (p->moves <= 8) {
-        int myCenter = __builtin_popcountll(cur & center);
-        int oppCenter = __builtin_popcountll(opp & center);
+        int myCenter = __builtin_popcountll(p->position & columnMask[3]);
+        int oppCenter = __builtin_popcountll(opponent_bb(p) & columnMask[3]);
         if (myCenter >= 2 && oppCenter >= 2) {
             score -= (myCenter - 1) * 20;
         }
@@ -528,53 +1039,239 @@ static int evaluate(const Position *p) {
     return score;
 }
 
+/* Forced-move quiescence. `p` has no immediate win and `next` (its
+   non-losing moves) is not empty. While there is exactly one
+   non-losing move it is played out, so a forced block at the horizon
+   is scored after the reply instead of statically; each step re-runs
+   the exact win/loss checks. */
+static int quiesce(const Position *p, uint64_t next, int budget,
+                   SearchThread *st, int ply) {
+    if (budget == 0 || (next & (next - 1))) {
+        return evaluate(p);
+    }
+
+    Position child = *p;
+    play_move(&child, __builtin_ctzll(next) / (ROWS + 1));
+    if (node_tick(st)) {
+        return evaluate(p);
+    }
+    if (ply + 1 > st->selDepth) {
+        st->selDepth = ply + 1;
+    }
+
+    if (child.moves == ROWS * COLS) {
+        return 0; /* draw */
+    }
+    /* the forced move was non-losing, so the reply cannot win at once */
+    uint64_t childNext = non_losing_moves(&child);
+    if (childNext == 0) {
+        return WIN_SCORE - (child.moves + 2);
+    }
+    return -quiesce(&child, childNext, budget - 1, st, ply + 1);
+}
+
+/* What negamax would return for a child at depth 0, given the threats
+   of the side that just moved (child_threats). The move was non-losing,
+   so the side to move here has no immediate win. */
+static inline int frontier_value(const Position *child, uint64_t oppWin,
+                                 SearchThread *st, int ply) {
+    if (child->moves == ROWS * COLS) {
+        return 0; /* draw */
+    }
+    uint64_t next = non_losing_cells(child->mask, oppWin);
+    if (next == 0) {
+        return LOSS_SCORE + (child->moves + 2);
+    }
+    return quiesce(child, next, QS_MAX_PLIES, st, ply);
+}
+
 /* ===============================================================
-   Transposition table (partitioned per thread)
+   Transposition table (shared, lock-free)
    =============================================================== */
 
-/* partition TT among threads by reserving low bits for thread id */
-static inline unsigned tt_index(uint64_t key, int thread_id) {
-#if USE_THREADS
-    unsigned idx = (unsigned)(key & TT_MASK);
-    /* reserve low bits for thread id (NUM_THREADS <= 8) */
-    unsigned lowMask = NUM_THREADS - 1;
-    idx = (idx & ~lowMask) | (unsigned)thread_id;
-    return idx;
-#else
-    (void)thread_id;
-    return (unsigned)(key & TT_MASK);
+static inline unsigned tt_index(uint64_t key) {
+    return (unsigned)(key >> (KEY_BITS - ttBucketBits));
+}
+
+/* The table is never cleared. Every search bumps ttGeneration and
+ * stamps what it stores, so entries left by earlier moves still hit
+ * but are the first to be replaced. A new game moves ttGameStart up,
+ * which makes everything older read as a miss (entries that survive a
+ * full 5-bit wrap-around come back, but TT values only depend on the
+ * position, so that is harmless). */
+#define TT_GEN_MASK 31u
+
+static unsigned ttGeneration = 0;
+static unsigned ttGameStart  = 0;
+
+/* Scores are packed into 16 bits: heuristic values are small and kept
+ * as is (clamped), win/loss scores keep their distance to the end. */
+#define TT_VALUE_MAX  32767
+#define TT_MATE_RANGE 64
+
+static inline int tt_encode_value(int v) {
+    if (v >= WIN_SCORE - TT_MATE_RANGE)  return TT_VALUE_MAX - (WIN_SCORE - v);
+    if (v <= LOSS_SCORE + TT_MATE_RANGE) return -TT_VALUE_MAX + (v - LOSS_SCORE);
+    if (v >  TT_VALUE_MAX - TT_MATE_RANGE - 1) return  TT_VALUE_MAX - TT_MATE_RANGE - 1;
+    if (v < -TT_VALUE_MAX + TT_MATE_RANGE + 1) return -TT_VALUE_MAX + TT_MATE_RANGE + 1;
+    return v;
+}
+
+static inline int tt_decode_value(int e) {
+    if (e >=  TT_VALUE_MAX - TT_MATE_RANGE) return WIN_SCORE  - (TT_VALUE_MAX - e);
+    if (e <= -TT_VALUE_MAX + TT_MATE_RANGE) return LOSS_SCORE + (e + TT_VALUE_MAX);
+    return e;
+}
+
+/* data layout: key:32 | value:16 | depth:6 | flag:2 | bestMove:3 | generation:5 */
+static inline uint64_t tt_pack(uint64_t key, int value, int depth, int flag,
+                               int bestMove) {
+    return  (uint64_t)(uint32_t)key
+         | ((uint64_t)(uint16_t)tt_encode_value(value) << 32)
+         | ((uint64_t)(depth & 63)                     << 48)
+         | ((uint64_t)(flag & 3)                       << 54)
+         | ((uint64_t)(bestMove & 7)                   << 56)
+         | ((uint64_t)(ttGeneration & TT_GEN_MASK)     << 59);
+}
+
+#define TT_MAX_DEPTH 63
+
+static inline int tt_value(uint64_t d)    { return tt_decode_value((int16_t)(uint16_t)(d >> 32)); }
+static inline int tt_depth(uint64_t d)    { return (int)((d >> 48) & 63); }
+static inline int tt_flag(uint64_t d)     { return (int)((d >> 54) & 3); }
+static inline int tt_bestMove(uint64_t d) {
+    int m = (int)((d >> 56) & 7);
+    return m == 7 ? -1 : m;
+}
+
+/* entries hold moves in the canonical orientation (see update_key) */
+static inline int tt_orient_move(const Position *p, int col) {
+    return (col >= 0 && p->mirrored) ? COLS - 1 - col : col;
+}
+
+/* number of searches since the entry was written (0 = this search) */
+static inline unsigned tt_age(uint64_t d) {
+    return (ttGeneration - (unsigned)(d >> 59)) & TT_GEN_MASK;
+}
+
+/* written before the current game started (see tt_new_game) */
+static inline int tt_old_game(uint64_t d) {
+    return tt_age(d) > ((ttGeneration - ttGameStart) & TT_GEN_MASK);
+}
+
+/* read a slot; returns 1 and the data word if it holds `key` */
+static inline int tt_read(const TTEntry *e, uint64_t key, uint64_t *outData) {
+    uint64_t data = atomic_load_explicit(e, memory_order_relaxed);
+    if ((uint32_t)data != (uint32_t)key || data == 0) return 0;
+    if (tt_old_game(data)) return 0;
+    *outData = data;
+    return 1;
+}
+
+static void tt_new_search(void) {
+    ttGeneration = (ttGeneration + 1) & TT_GEN_MASK;
+}
+
+static void tt_new_game(void) {
+    ttGameStart = (ttGeneration + 1) & TT_GEN_MASK;
+}
+
+/* how much an entry is worth keeping: deep and recent entries win;
+   entries of an earlier game can no longer hit, so they count as empty */
+static inline int tt_keep_score(uint64_t d) {
+    if (d == 0 || tt_old_game(d)) return INT_MIN;
+    return tt_depth(d) - 8 * (int)tt_age(d);
+}
+
+static inline void tt_prefetch(uint64_t key) {
+    __builtin_prefetch(&tt[tt_index(key)]);
+}
+
+/* map `bytes` of zeroed memory, 2MB aligned so it can be backed by
+   transparent huge pages; NULL on failure */
+static void *tt_map(size_t bytes) {
+    size_t span = bytes + TT_HUGE_PAGE;
+    uint8_t *raw = mmap(NULL, span, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+
+    /* trim the unaligned head and the tail */
+    uintptr_t addr = ((uintptr_t)raw + TT_HUGE_PAGE - 1) & ~(uintptr_t)(TT_HUGE_PAGE - 1);
+    uint8_t *mem = (uint8_t *)addr;
+    if (mem > raw) munmap(raw, (size_t)(mem - raw));
+    if (mem + bytes < raw + span) munmap(mem + bytes, (size_t)(raw + span - (mem + bytes)));
+
+#ifdef MADV_HUGEPAGE
+    /* best effort: without THP the kernel just uses normal pages */
+    madvise(mem, bytes, MADV_HUGEPAGE);
 #endif
+    return mem;
 }
 
-static inline uint64_t hash_position(const Position *p) {
-    uint64_t x = p->position * 0x9E3779B185EBCA87ULL;
-    uint64_t y = p->mask      * 0xC2B2AE3D27D4EB4FULL;
-    x ^= y >> 23;
-    y ^= x << 17;
-    return x ^ y;
+static void tt_free(void) {
+    if (tt && tt != &ttFallback) munmap(tt, ttBytes);
+    tt = NULL;
+    ttBytes = 0;
+    ttBucketBits = 0;
+}
+
+/* allocate the table at the requested size, halving on failure */
+static void tt_alloc(void) {
+    unsigned bits = 0;
+    while (bits < KEY_BITS &&
+           ((size_t)sizeof(TTBucket) << (bits + 1)) <= (ttRequestedMB << 20)) {
+        bits++;
+    }
+
+    for (; bits > 0; --bits) {
+        size_t bytes = (size_t)sizeof(TTBucket) << bits;
+        void *mem = tt_map(bytes);
+        if (mem) {
+            tt = mem;
+            ttBytes = bytes;
+            ttBucketBits = bits;
+            return;
+        }
+    }
+
+    fprintf(stderr, "[HARD BOT] could not map the transposition table, using a single bucket.\n");
+    memset(&ttFallback, 0, sizeof(ttFallback));
+    tt = &ttFallback;
+    ttBytes = sizeof(ttFallback);
+    ttBucketBits = 0;
+}
+
+/* find the entry for `key` in its bucket */
+static inline int tt_lookup(uint64_t key, uint64_t *outData) {
+    TTBucket *b = &tt[tt_index(key)];
+    for (int i = 0; i < TT_WAYS; ++i) {
+        if (tt_read(&b->e[i], key, outData)) return 1;
+    }
+    return 0;
 }
 
 /* TT probe now also returns bestMove hint (for move ordering) */
 static int tt_probe(const Position *p, int depth, int alpha, int beta,
-                    int *outVal, int *outBestMove, int thread_id) {
-    uint64_t key = hash_position(p);
-    TTEntry *e = &tt[tt_index(key, thread_id)];
+                    int *outVal, int *outBestMove) {
+    uint64_t key = p->key;
+    uint64_t d;
 
-    if (e->key != key || e->depth < depth) {
+    if (!tt_lookup(key, &d) || tt_depth(d) < depth) {
         return 0;
     }
 
-    int v = e->value;
+    int v = tt_value(d);
     if (outBestMove) {
-        *outBestMove = e->bestMove;   /* can be -1..6 */
+        *outBestMove = tt_orient_move(p, tt_bestMove(d));   /* can be -1..6 */
     }
 
-    if (e->flag == 0) {
+    int flag = tt_flag(d);
+    if (flag == 0) {
         *outVal = v;
         return 1;
     }
-    if (e->flag == 1 && v > alpha) alpha = v;
-    if (e->flag == 2 && v < beta)  beta  = v;
+    if (flag == 1 && v > alpha) alpha = v;
+    if (flag == 2 && v < beta)  beta  = v;
     if (alpha >= beta) {
         *outVal = v;
         return 1;
@@ -583,146 +1280,533 @@ static int tt_probe(const Position *p, int depth, int alpha, int beta,
 }
 
 static void tt_store(const Position *p, int depth, int value, int flag,
-                     int bestMove, int thread_id) {
-    uint64_t key = hash_position(p);
-    TTEntry *e = &tt[tt_index(key, thread_id)];
+                     int bestMove) {
+    uint64_t key = p->key;
+    bestMove = tt_orient_move(p, bestMove);
+    TTBucket *b = &tt[tt_index(key)];
+    TTEntry *e = NULL;
+    uint64_t old;
+
+    /* same position already stored: update it in place */
+    for (int i = 0; i < TT_WAYS; ++i) {
+        if (tt_read(&b->e[i], key, &old)) {
+            if (tt_age(old) == 0 && tt_depth(old) > depth) {
+                return; /* keep deeper entry from this search */
+            }
+            e = &b->e[i];
+            break;
+        }
+    }
 
-    if (e->key == key && e->depth > depth) {
-        return; /* keep deeper entry */
+    /* otherwise evict the least valuable depth-preferred way, as long as
+       the new entry is at least as deep (or the victim is stale); if not,
+       fall back to the always-replace way */
+    if (!e) {
+        int victim = 0;
+        int victimScore = INT_MAX;
+        for (int i = 0; i < TT_WAYS - 1; ++i) {
+            int sc = tt_keep_score(atomic_load_explicit(&b->e[i],
+                                                        memory_order_relaxed));
+            if (sc < victimScore) {
+                victimScore = sc;
+                victim = i;
+            }
+        }
+        e = (victimScore <= depth) ? &b->e[victim] : &b->e[TT_WAYS - 1];
     }
-    e->key      = key;
-    e->depth    = (int16_t)depth;
-    e->value    = value;
-    e->flag     = (int8_t)flag;
-    e->bestMove = (int8_t)bestMove;
-}
 
-/* ===============================================================
-   Core negamax + alpha-beta + LMR (+ selective depth tracking)
-   =============================================================== */
+    atomic_store_explicit(e, tt_pack(key, value, depth, flag, bestMove),
+                          memory_order_relaxed);
+}
 
-static int negamax(Position *p, int depth, int alpha, int beta,
-                   int thread_id, int ply) {
-    if (timeExpired || time_up()) {
-        timeExpired = 1;
-        return evaluate(p);
+/* remember a move that caused a beta cut (killers + history) */
+static void record_cutoff(SearchThread *st, const Position *p, int col,
+                          int depth, int ply) {
+    if (ply < KILLER_PLIES && st->killers[ply][0] != col) {
+        st->killers[ply][1] = st->killers[ply][0];
+        st->killers[ply][0] = (int8_t)col;
     }
 
-    /* track deepest selective depth reached */
-    if (ply > lastSelectiveDepth) {
-        lastSelectiveDepth = ply;
+    int side = p->moves & 1;
+    int cell = __builtin_ctzll((p->mask + bottomMask[col]) & columnMask[col]);
+    st->history[side][cell] += depth * depth;
+    if (st->history[side][cell] > HISTORY_MAX) {
+        for (int i = 0; i < COLS * 7; ++i) {
+            st->history[side][i] /= 2;
+        }
     }
+}
 
-    int remaining = ROWS * COLS - p->moves;
-    /* in very late endgame, don’t search deeper than remaining moves */
-    if (remaining <= 8 && depth > remaining) {
-        depth = remaining;
-    }
+/* ===============================================================
+   Leaf search (last two plies)
+   ---------------------------------------------------------------
+   Plain alpha-beta on bitboards: no TT, book, LMR or move-list
+   copies. Immediate wins never occur (moves come from the non-losing
+   set), forced blocks and lost positions fall out of the children's
+   threat boards, and depth-0 children are scored by frontier_value
+   (forced-move quiescence).
+   `p` has no immediate win and `next` (its non-losing moves) is not
+   empty; p itself was already counted as a node.
+   =============================================================== */
 
-    /* if previous player already made a connect-4, this is losing */
-    uint64_t opp = opponent_bb(p);
-    if (has_connect4(opp)) {
-        return LOSS_SCORE + p->moves;
-    }
+CPU_DISPATCH
+static int leaf_search(const Position *p, uint64_t next, int depth,
+                       int alpha, int beta, SearchThread *st, int ply) {
+    uint64_t threats[COLS];
+    child_threats(p, next, threats);
 
-    if (p->moves == ROWS * COLS) {
-        return 0; /* draw */
-    }
+    int cols[COLS];
+    int count = order_moves(p, next, threats, -1, NULL, 0, cols);
 
-    if (depth == 0) {
-        return evaluate(p);
+    if (ply + 1 > st->selDepth) {
+        st->selDepth = ply + 1;
     }
 
-    int alphaOrig = alpha;
-    int ttVal;
-    int ttMove = -1;
+    int bestVal = -INF_SCORE;
+    for (int i = 0; i < count; ++i) {
+        int col = cols[i];
+        Position child = *p;
+        play_move(&child, col);
 
-    /* TT lookup: may give us a value AND a suggested bestMove for ordering */
-    if (tt_probe(p, depth, alpha, beta, &ttVal, &ttMove, thread_id)) {
-        return ttVal;
+        if (node_tick(st)) {
+            return evaluate(p);
+        }
+
+        int val;
+        if (depth == 1) {
+            val = -frontier_value(&child, threats[col], st, ply + 1);
+        } else if (child.moves == ROWS * COLS) {
+            val = 0;  /* draw */
+        } else {
+            uint64_t childNext = non_losing_cells(child.mask, threats[col]);
+            val = childNext ? -leaf_search(&child, childNext, 1, -beta, -alpha, st, ply + 1)
+                            : -(LOSS_SCORE + child.moves + 2);
+            if (search_aborted(st)) {
+                return evaluate(p);
+            }
+        }
+
+        if (val > bestVal) bestVal = val;
+        if (val > alpha)   alpha = val;
+        if (alpha >= beta) break;
     }
+    return bestVal;
+}
 
-    int bestVal  = -INF_SCORE;
-    int bestMove = -1;
+/* ===============================================================
+   Child search (PVS + LMR), shared by negamax and split points
+   =============================================================== */
 
-    /* ----- Build ordered move list for this node -----
-       1) TT bestMove first (if valid & playable)
-       2) Then remaining moves in center-first order
-    */
-    int ordered[COLS];
-    int count = 0;
+CPU_DISPATCH
+static int negamax(Position *p, int depth, int alpha, int beta,
+                   int thread_id, int ply);
+
+/* Score of child `i` of a node's ordered move list, from the node's
+   side. The first move gets the full window; the rest are scouted
+   with a null window, at reduced depth first for late moves (LMR;
+   immediate wins never get this far), and only re-searched when they
+   beat alpha. The caller checks search_aborted() before using it. */
+static int search_child(Position *child, int i, int depth, int alpha, int beta,
+                        int thread_id, int ply) {
+    SearchThread *st = &g_threads[thread_id];
+    int newDepth = depth - 1;
+
+    if (i == 0) {
+        return -negamax(child, newDepth, -beta, -alpha, thread_id, ply + 1);
+    }
 
-    if (ttMove >= 0 && ttMove < COLS && can_play(p, ttMove)) {
-        ordered[count++] = ttMove;
+    int scoutDepth = newDepth;
+    if (newDepth >= LMR_MIN_DEPTH && i >= LMR_MOVE_INDEX) {
+        scoutDepth = newDepth - LMR_REDUCTION;
+        if (scoutDepth < 1) scoutDepth = 1;
     }
 
-    for (int i = 0; i < COLS; ++i) {
-        int col = moveOrder[i];
-        if (col == ttMove) continue;      /* already added */
-        if (!can_play(p, col)) continue;
-        ordered[count++] = col;
+    int val = -negamax(child, scoutDepth, -alpha - 1, -alpha, thread_id, ply + 1);
+    if (search_aborted(st)) return val;
+
+    /* reduced scout failed high: verify at full depth */
+    if (val > alpha && scoutDepth < newDepth) {
+        val = -negamax(child, newDepth, -alpha - 1, -alpha, thread_id, ply + 1);
+        if (search_aborted(st)) return val;
     }
 
-    /* Fallback: if still no moves collected, just scan all columns */
-    if (count == 0) {
-        for (int c = 0; c < COLS; ++c) {
-            if (can_play(p, c)) {
-                ordered[count++] = c;
+    /* inside the window: get the exact score */
+    if (val > alpha && val < beta) {
+        val = -negamax(child, newDepth, -beta, -alpha, thread_id, ply + 1);
+    }
+    return val;
+}
+
+/* ===============================================================
+   Split points (young brothers wait, HARD_BOT_YBWC)
+   ---------------------------------------------------------------
+   A node searches its first move alone. If some thread is idle it
+   then opens a split point for the other moves on its own deque and
+   keeps taking moves from it, while idle threads steal moves from
+   the oldest (largest) split points of the others. Results go into
+   the split point's alpha / best under its lock, and a beta cut there
+   aborts every thread below it (search_aborted). An owner whose moves
+   are all handed out waits for its helpers, joining only split
+   points below its own in the meantime. Threads with nothing to do
+   sleep on a condition variable until a split point opens, a helper
+   leaves one, or the move is decided.
+   =============================================================== */
+
+#if USE_THREADS
+
+/* open split points of one thread, oldest first: the owner pushes and
+   pops at the back, thieves look from the front */
+typedef struct {
+    pthread_mutex_t lock;
+    SplitPoint     *items[SPLIT_MAX_NESTED];
+    atomic_int      size;
+} SplitDeque;
+
+static SplitDeque g_splitDeques[SMP_MAX_THREADS];
+static atomic_int g_splitIdle;   /* helpers looking for work     */
+
+/* wake-ups for idle threads: the epoch changes (under g_splitLock)
+   whenever there may be new work, so a thread that read it before
+   looking for work and found none cannot miss the next change */
+static pthread_mutex_t g_splitLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_splitWake = PTHREAD_COND_INITIALIZER;
+static atomic_uint     g_splitEpoch;
+static int             g_splitDone;   /* set once the move is decided */
+
+static void split_init(void) {
+    for (int i = 0; i < SMP_MAX_THREADS; ++i) {
+        pthread_mutex_init(&g_splitDeques[i].lock, NULL);
+    }
+}
+
+static inline unsigned split_epoch(void) {
+    return atomic_load(&g_splitEpoch);
+}
+
+static void split_wake(void) {
+    pthread_mutex_lock(&g_splitLock);
+    atomic_fetch_add(&g_splitEpoch, 1);
+    pthread_cond_broadcast(&g_splitWake);
+    pthread_mutex_unlock(&g_splitLock);
+}
+
+/* sleep until the epoch moves past `epoch` or the move is decided */
+static void split_park(unsigned epoch) {
+    pthread_mutex_lock(&g_splitLock);
+    while (!g_splitDone && split_epoch() == epoch) {
+        pthread_cond_wait(&g_splitWake, &g_splitLock);
+    }
+    pthread_mutex_unlock(&g_splitLock);
+}
+
+static void split_set_done(int done) {
+    pthread_mutex_lock(&g_splitLock);
+    g_splitDone = done;
+    pthread_cond_broadcast(&g_splitWake);
+    pthread_mutex_unlock(&g_splitLock);
+}
+
+/* worth opening a split point on this thread now? */
+static inline int split_wanted(int thread_id) {
+    return atomic_load_explicit(&g_splitIdle, memory_order_relaxed) > 0 &&
+           atomic_load_explicit(&g_splitDeques[thread_id].size,
+                                memory_order_relaxed) < SPLIT_MAX_NESTED;
+}
+
+static inline int split_below(const SplitPoint *sp, const SplitPoint *within) {
+    for (; sp; sp = sp->parent) {
+        if (sp == within) return 1;
+    }
+    return 0;
+}
+
+/* take moves from `sp` until none are left or it was cut */
+static void split_work(SplitPoint *sp, int thread_id) {
+    SearchThread *st = &g_threads[thread_id];
+    SplitPoint *outer = st->split;
+    st->split = sp;
+
+    pthread_mutex_lock(&sp->lock);
+    while (sp->next < sp->count &&
+           !atomic_load_explicit(&sp->cutoff, memory_order_relaxed)) {
+        int i = sp->next++;
+        int alpha = sp->alpha;
+        pthread_mutex_unlock(&sp->lock);
+
+        Position child = sp->children[i];
+        int val = search_child(&child, i, sp->depth, alpha, sp->beta,
+                               thread_id, sp->ply);
+
+        pthread_mutex_lock(&sp->lock);
+        if (search_aborted(st)) break;
+
+        /* (val is a lower bound whenever it beats alpha) */
+        if (sp->ply == 0 && val >= PROVEN_WIN && val > alpha) {
+            publish_root_win(sp->cols[i], val);
+        }
+
+        if (val > sp->bestVal) {
+            sp->bestVal  = val;
+            sp->bestMove = sp->cols[i];
+        }
+        if (val > sp->alpha) {
+            sp->alpha = val;
+        }
+        if (sp->alpha >= sp->beta) {  /* beta cut */
+            record_cutoff(st, sp->pos, sp->cols[i], sp->depth, sp->ply);
+            atomic_store_explicit(&sp->cutoff, 1, memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&sp->lock);
+
+    st->split = outer;
+}
+
+/* join another thread's split point that still has moves to hand out
+   (with `within`, only one below it); 0 if there was none */
+static int split_steal(int thread_id, const SplitPoint *within) {
+    for (int k = 1; k < SMP_MAX_THREADS; ++k) {
+        SplitDeque *dq = &g_splitDeques[(thread_id + k) % SMP_MAX_THREADS];
+        if (atomic_load_explicit(&dq->size, memory_order_relaxed) == 0) continue;
+
+        /* holding the deque lock keeps its split points alive */
+        SplitPoint *sp = NULL;
+        pthread_mutex_lock(&dq->lock);
+        int size = atomic_load_explicit(&dq->size, memory_order_relaxed);
+        for (int j = 0; j < size && !sp; ++j) {
+            SplitPoint *cand = dq->items[j];
+            if (within && !split_below(cand, within)) continue;
+
+            pthread_mutex_lock(&cand->lock);
+            if (cand->next < cand->count &&
+                !atomic_load_explicit(&cand->cutoff, memory_order_relaxed)) {
+                cand->joined++;
+                sp = cand;
             }
+            pthread_mutex_unlock(&cand->lock);
         }
+        pthread_mutex_unlock(&dq->lock);
+        if (!sp) continue;
+
+        if (!within) atomic_fetch_sub(&g_splitIdle, 1);
+        split_work(sp, thread_id);
+        if (!within) atomic_fetch_add(&g_splitIdle, 1);
+
+        pthread_mutex_lock(&sp->lock);
+        int last = (--sp->joined == 0);
+        pthread_mutex_unlock(&sp->lock);
+        if (last) split_wake();   /* its owner may be asleep */
+        return 1;
     }
+    return 0;
+}
 
-    int localAlpha = alpha;
+/* Share moves 1..count-1 of a node whose first move is searched. On
+   return alpha, bestVal and bestMove cover every move (unless the
+   search was aborted, which the caller checks). */
+static void split_node(const Position *p, const Position children[],
+                       const int cols[], int count, int depth,
+                       int *alpha, int beta, int *bestVal, int *bestMove,
+                       int thread_id, int ply) {
+    SearchThread *st = &g_threads[thread_id];
+    SplitDeque *dq = &g_splitDeques[thread_id];
+    SplitPoint sp;
+
+    pthread_mutex_init(&sp.lock, NULL);
+    sp.pos      = p;
+    sp.children = children;
+    sp.cols     = cols;
+    sp.count    = count;
+    sp.depth    = depth;
+    sp.beta     = beta;
+    sp.ply      = ply;
+    sp.parent   = st->split;
+    atomic_init(&sp.cutoff, 0);
+    sp.next     = 1;
+    sp.joined   = 0;
+    sp.alpha    = *alpha;
+    sp.bestVal  = *bestVal;
+    sp.bestMove = *bestMove;
+
+    pthread_mutex_lock(&dq->lock);
+    int size = atomic_load_explicit(&dq->size, memory_order_relaxed);
+    dq->items[size] = &sp;
+    atomic_store_explicit(&dq->size, size + 1, memory_order_relaxed);
+    pthread_mutex_unlock(&dq->lock);
+    split_wake();
+
+    split_work(&sp, thread_id);
+
+    pthread_mutex_lock(&dq->lock);
+    atomic_store_explicit(&dq->size, size, memory_order_relaxed);
+    pthread_mutex_unlock(&dq->lock);
+
+    /* wait for the helpers, working below this node meanwhile */
+    for (;;) {
+        unsigned epoch = split_epoch();
+        pthread_mutex_lock(&sp.lock);
+        int joined = sp.joined;
+        pthread_mutex_unlock(&sp.lock);
+        if (joined == 0) break;
+        if (!split_steal(thread_id, &sp)) split_park(epoch);
+    }
 
-    for (int i = 0; i < count; ++i) {
-        int col = ordered[i];
+    *alpha    = sp.alpha;
+    *bestVal  = sp.bestVal;
+    *bestMove = sp.bestMove;
+    pthread_mutex_destroy(&sp.lock);
+}
 
-        Position child = *p;
-        play_move(&child, col);
+/* pool job for every thread but the caller's: steal moves until the
+   move is decided */
+static void split_helper(void *arg) {
+    int thread_id = *(const int *)arg;
+
+    atomic_fetch_add(&g_splitIdle, 1);
+    for (;;) {
+        unsigned epoch = split_epoch();
+        pthread_mutex_lock(&g_splitLock);
+        int done = g_splitDone;
+        pthread_mutex_unlock(&g_splitLock);
+        if (done) break;
+        if (!split_steal(thread_id, NULL)) split_park(epoch);
+    }
+    atomic_fetch_sub(&g_splitIdle, 1);
+}
 
-        /* Check if this move immediately wins (for LMR safety) */
-        uint64_t prevPlayerBB = opponent_bb(&child);  /* previous mover's stones */
-        int immediateWin = has_connect4(prevPlayerBB);
+#endif
 
-        int newDepth = depth - 1;
-        int val;
+/* ===============================================================
+   Core negamax + alpha-beta + PVS/LMR (+ selective depth tracking)
+   =============================================================== */
 
-        /* LMR: for later moves at sufficient depth that are NOT immediate wins,
-           try a reduced-depth null-window search first. */
-        int doLMR = (newDepth >= LMR_MIN_DEPTH &&
-                     i >= LMR_MOVE_INDEX &&
-                     !immediateWin);
+CPU_DISPATCH
+static int negamax(Position *p, int depth, int alpha, int beta,
+                   int thread_id, int ply) {
+    SearchThread *st = &g_threads[thread_id];
+    if (node_tick(st)) {
+        return evaluate(p);
+    }
 
-        if (doLMR) {
-            int rDepth = newDepth - LMR_REDUCTION;
-            if (rDepth < 1) rDepth = 1;
+    /* track deepest selective depth reached */
+    if (ply > st->selDepth) {
+        st->selDepth = ply;
+    }
 
-            /* Reduced-depth null-window search */
-            val = -negamax(&child, rDepth,
-                           -localAlpha - 1, -localAlpha,
-                           thread_id, ply + 1);
+    int remaining = ROWS * COLS - p->moves;
+    /* in very late endgame, don’t search deeper than remaining moves */
+    if (remaining <= 8 && depth > remaining) {
+        depth = remaining;
+    }
 
-            if (timeExpired) {
-                return evaluate(p);
-            }
+    /* if previous player already made a connect-4, this is losing */
+    uint64_t opp = opponent_bb(p);
+    if (has_connect4(opp)) {
+        return LOSS_SCORE + p->moves;
+    }
 
-            /* If it looks interesting, re-search with full depth/window */
-            if (val > localAlpha) {
-                val = -negamax(&child, newDepth,
-                               -beta, -localAlpha,
-                               thread_id, ply + 1);
-                if (timeExpired) {
-                    return evaluate(p);
-                }
-            }
-        } else {
-            /* Normal full-depth search */
-            val = -negamax(&child, newDepth,
-                           -beta, -localAlpha,
-                           thread_id, ply + 1);
-            if (timeExpired) {
-                return evaluate(p);
-            }
+    if (p->moves == ROWS * COLS) {
+        return 0; /* draw */
+    }
+
+    /* a win on this move or a loss on the next one is exact at any depth */
+    if (winning_cells(p->position, p->mask) & playable_cells(p->mask)) {
+        return WIN_SCORE - (p->moves + 1);
+    }
+    uint64_t next = non_losing_moves(p);
+    if (next == 0) {
+        return LOSS_SCORE + (p->moves + 2);
+    }
+
+    /* mate-distance bounds: with neither of the above, the earliest we
+       can still win is with our next-but-one stone and the earliest we
+       can lose is to the opponent's second stone from here (the engine
+       form of the solver's (W*H-1-moves)/2 bound) */
+    int maxScore = WIN_SCORE - (p->moves + 3);
+    int minScore = LOSS_SCORE + (p->moves + 4);
+
+    /* dead lines: a side with no four left open cannot beat a draw,
+       and with neither side able to win the game is already drawn */
+    if (p->moves >= DEAD_MIN_MOVES) {
+        int weCan = can_still_win(p->position, p->mask);
+        int theyCan = can_still_win(opp, p->mask);
+        if (!weCan && !theyCan) {
+            return 0;
+        }
+        if (!weCan)   maxScore = 0;
+        if (!theyCan) minScore = 0;
+    }
+
+    if (beta > maxScore) {
+        beta = maxScore;
+        if (alpha >= beta) return beta;
+    }
+    if (alpha < minScore) {
+        alpha = minScore;
+        if (alpha >= beta) return alpha;
+    }
+
+    if (depth == 0) {
+        return quiesce(p, next, QS_MAX_PLIES, st, ply);
+    }
+
+    /* the last two plies skip the TT, book and LMR entirely */
+    if (depth <= 2 && !(g_book.ok && p->moves <= g_book.depth)) {
+        return leaf_search(p, next, depth, alpha, beta, st, ply);
+    }
+
+    int alphaOrig = alpha;
+    int ttVal;
+    int ttMove = -1;
+
+    /* TT lookup: may give us a value AND a suggested bestMove for ordering */
+    if (tt_probe(p, depth, alpha, beta, &ttVal, &ttMove)) {
+        return ttVal;
+    }
+
+    /* within book depth the exact score is one probe away; keep it in
+       the TT at maximum depth so the next visit is a plain TT hit */
+    if (g_book.ok && p->moves <= g_book.depth) {
+        int bookVal;
+        st->bookProbes++;
+        if (book_engine_score(p, &bookVal)) {
+            st->bookHits++;
+            tt_store(p, TT_MAX_DEPTH, bookVal, 0, -1);
+            return bookVal;
+        }
+    }
+
+    int bestVal  = -INF_SCORE;
+    int bestMove = -1;
+
+    /* ----- Build ordered move list for this node -----
+       Only moves that don't hand the opponent an immediate win (the
+       single block when it has a threat): TT bestMove first, then the
+       moves creating the most threats of our own, ties center-first.
+    */
+    uint64_t threats[COLS];
+    child_threats(p, next, threats);
+
+    int ordered[COLS];
+    int count = order_moves(p, next, threats, ttMove, st, ply, ordered);
+
+    /* play every child once and start pulling their TT buckets into
+       cache now; the first ones are needed as soon as we recurse */
+    Position children[COLS];
+    for (int i = 0; i < count; ++i) {
+        children[i] = *p;
+        play_move(&children[i], ordered[i]);
+        tt_prefetch(children[i].key);
+    }
+
+    int localAlpha = alpha;
+
+    for (int i = 0; i < count; ++i) {
+        int col = ordered[i];
+        int val = search_child(&children[i], i, depth, localAlpha, beta,
+                               thread_id, ply);
+        if (search_aborted(st)) {
+            return evaluate(p);
         }
 
         if (val > bestVal) {
@@ -732,7 +1816,24 @@ static int negamax(Position *p, int depth, int alpha, int beta,
         if (val > localAlpha) {
             localAlpha = val;
         }
-        if (localAlpha >= beta) break; /* beta cut */
+        if (localAlpha >= beta) {  /* beta cut */
+            record_cutoff(st, p, col, depth, ply);
+            break;
+        }
+
+#if USE_THREADS
+        /* young brothers wait: the first move is searched, so the
+           rest can go to idle threads */
+        if (i == 0 && count > 2 && depth >= SPLIT_MIN_DEPTH &&
+            split_wanted(thread_id)) {
+            split_node(p, children, ordered, count, depth, &localAlpha, beta,
+                       &bestVal, &bestMove, thread_id, ply);
+            if (search_aborted(st)) {
+                return evaluate(p);
+            }
+            break;
+        }
+#endif
     }
 
     if (bestMove == -1) {
@@ -744,10 +1845,191 @@ static int negamax(Position *p, int depth, int alpha, int beta,
     else if (bestVal >= beta)      flag = 1; /* lower bound */
     else                           flag = 0; /* exact */
 
-    tt_store(p, depth, bestVal, flag, bestMove, thread_id);
+    tt_store(p, depth, bestVal, flag, bestMove);
     return bestVal;
 }
 
+/* ===============================================================
+   Exact solver (Pascal Pons style)
+   ---------------------------------------------------------------
+   Works on Pascal scores: s > 0 means the side to move wins, the
+   larger the sooner; s < 0 it loses; 0 is a draw. Results go into
+   the shared TT as bounds at TT_MAX_DEPTH (converted to the engine
+   scale), so negamax can use them too and the solver only trusts
+   entries that are solved (book hits and its own).
+   =============================================================== */
+
+/* assumes the side to move cannot win immediately; `alpha < beta` */
+CPU_DISPATCH
+static int solve_negamax(const Position *p, int alpha, int beta, SearchThread *st) {
+    if (node_tick(st)) return 0;
+
+    uint64_t next = non_losing_moves(p);
+    if (next == 0) {
+        return -(ROWS * COLS - p->moves) / 2;     /* opponent wins next move */
+    }
+    if (p->moves >= ROWS * COLS - 2) {
+        return 0;                                  /* two cells left: draw */
+    }
+
+    /* we cannot win this move, so at best we lose with the next one
+       and win with the one after; a side with no open four left is
+       held to a draw */
+    int min = -(ROWS * COLS - 2 - p->moves) / 2;
+    int max = (ROWS * COLS - 1 - p->moves) / 2;
+    if (p->moves >= DEAD_MIN_MOVES) {
+        int weCan = can_still_win(p->position, p->mask);
+        int theyCan = can_still_win(opponent_bb(p), p->mask);
+        if (!weCan && !theyCan) {
+            return 0;
+        }
+        if (!weCan)   max = 0;
+        if (!theyCan) min = 0;
+    }
+    if (alpha < min) {
+        alpha = min;
+        if (alpha >= beta) return alpha;
+    }
+    if (beta > max) {
+        beta = max;
+        if (alpha >= beta) return beta;
+    }
+
+    uint64_t key = p->key;
+    uint64_t d;
+    int ttMove = -1;
+    if (tt_lookup(key, &d)) {
+        ttMove = tt_orient_move(p, tt_bestMove(d));
+        if (tt_depth(d) == TT_MAX_DEPTH) {
+            int v = engine_to_pascal(tt_value(d), p->moves);
+            int flag = tt_flag(d);
+            if (flag == 0) return v;
+            if (flag == 1 && v > alpha) alpha = v;
+            if (flag == 2 && v < beta)  beta  = v;
+            if (alpha >= beta) return v;
+        }
+    }
+
+    if (g_book.ok && p->moves <= g_book.depth) {
+        int bookVal;
+        st->bookProbes++;
+        if (book_engine_score(p, &bookVal)) {
+            st->bookHits++;
+            tt_store(p, TT_MAX_DEPTH, bookVal, 0, -1);
+            return engine_to_pascal(bookVal, p->moves);
+        }
+    }
+
+    uint64_t threats[COLS];
+    child_threats(p, next, threats);
+
+    int cols[COLS];
+    int count = order_moves(p, next, threats, ttMove, NULL, 0, cols);
+
+    for (int i = 0; i < count; ++i) {
+        Position child = *p;
+        play_move(&child, cols[i]);
+
+        int score = -solve_negamax(&child, -beta, -alpha, st);
+        if (search_aborted(st)) return 0;
+
+        if (score >= beta) {
+            tt_store(p, TT_MAX_DEPTH, pascal_to_engine(score, p->moves), 1, cols[i]);
+            return score;
+        }
+        if (score > alpha) alpha = score;
+    }
+
+    tt_store(p, TT_MAX_DEPTH, pascal_to_engine(alpha, p->moves), 2, -1);
+    return alpha;
+}
+
+/* exact Pascal score by null-window bisection over the possible range;
+   0 (and search_aborted) if the search was interrupted */
+static int solve_exact(const Position *p, SearchThread *st) {
+    if (winning_cells(p->position, p->mask) & playable_cells(p->mask)) {
+        return (ROWS * COLS + 1 - p->moves) / 2;
+    }
+
+    int min = -(ROWS * COLS - p->moves) / 2;
+    int max = (ROWS * COLS + 1 - p->moves) / 2;
+
+    while (min < max) {
+        int med = min + (max - min) / 2;
+        /* probe near 0 first: most positions are close to a draw */
+        if (med <= 0 && min / 2 < med)      med = min / 2;
+        else if (med >= 0 && max / 2 > med) med = max / 2;
+
+        int r = solve_negamax(p, med, med + 1, st);
+        if (search_aborted(st)) return 0;
+
+        if (r <= med) max = r;
+        else          min = r;
+    }
+    return min;
+}
+
+/* Solver mode at the root: exact score by bisection, then the first
+   move (TT move, then center-first) that proves it with one null
+   window. Returns 0 if the limits stopped it before the score was
+   known; *outMove is still the best guess. */
+static int solve_root(const Position *root, SearchThread *st,
+                      int *outMove, int *outScore) {
+    uint64_t wins = winning_cells(root->position, root->mask) & playable_cells(root->mask);
+    uint64_t next = non_losing_moves(root);
+
+    *outMove = -1;
+    for (int c = 0; c < COLS; ++c) {
+        if (wins & columnMask[c]) {
+            *outScore = (ROWS * COLS + 1 - root->moves) / 2;
+            *outMove  = c;
+            return 1;
+        }
+    }
+    for (int i = 0; i < COLS && *outMove < 0; ++i) {
+        if (next & columnMask[moveOrder[i]]) *outMove = moveOrder[i];
+    }
+    if (*outMove < 0) {
+        /* every move loses at once: at least block one threat */
+        uint64_t block = winning_cells(opponent_bb(root), root->mask) &
+                         playable_cells(root->mask);
+        for (int c = 0; c < COLS; ++c) {
+            if (can_play(root, c) && (*outMove < 0 || (block & columnMask[c]))) {
+                *outMove = c;
+            }
+        }
+        *outScore = -(ROWS * COLS - root->moves) / 2;
+        return 1;
+    }
+
+    int score = solve_exact(root, st);
+
+    /* the TT move of the last bisection step usually proves it first */
+    uint64_t d;
+    if (tt_lookup(root->key, &d)) {
+        int ttMove = tt_orient_move(root, tt_bestMove(d));
+        if (ttMove >= 0 && (next & columnMask[ttMove])) *outMove = ttMove;
+    }
+    if (search_aborted(st)) return 0;
+    *outScore = score;
+
+    for (int i = -1; i < COLS; ++i) {
+        int col = (i < 0) ? *outMove : moveOrder[i];
+        if (i >= 0 && col == *outMove) continue;
+        if (!(next & columnMask[col])) continue;
+
+        Position child = *root;
+        play_move(&child, col);
+        int r = -solve_negamax(&child, -score, -score + 1, st);
+        if (search_aborted(st)) return 0;
+        if (r >= score) {
+            *outMove = col;
+            break;
+        }
+    }
+    return 1;
+}
+
 /* ===============================================================
    Convert from char board[ROWS][COLS] to bitboard Position
    =============================================================== */
@@ -788,51 +2070,147 @@ static void load_board(Position *pos,
     pos->mask     = mask;
     pos->moves    = countBot + countOpp;
     pos->position = pBot;  /* root is always from BOT's POV (bot is to move) */
+    init_position(pos);
 }
 
 /* ===============================================================
-   Root-level multithreading helper
+   Persistent worker pool
+   ---------------------------------------------------------------
+   Workers are created once and park on a condition variable between
+   jobs. The thread that waits for the pool also runs queued jobs, so
+   a pool of N threads has N-1 workers and N = 1 is plain serial.
    =============================================================== */
 
 #if USE_THREADS
 
+typedef void (*PoolFn)(void *arg);
+
 typedef struct {
-    Position root;
-    int depth;
-    int col;
-    int thread_id;
-    int alpha;
-    int beta;
-    int score;
-    int valid;
-} ThreadTask;
+    PoolFn fn;
+    void  *arg;
+} PoolJob;
 
-static void *thread_search(void *arg) {
-    ThreadTask *task = (ThreadTask *)arg;
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  workReady;  /* signalled when a job is queued      */
+    pthread_cond_t  allDone;    /* signalled when the pool goes idle   */
+    pthread_t       workers[SMP_MAX_THREADS];
+    int             workerCount;
+    PoolJob         queue[POOL_QUEUE_SIZE];
+    int             head;
+    int             queued;
+    int             active;     /* jobs currently running              */
+    int             shutdown;
+} WorkerPool;
+
+static WorkerPool g_pool = {
+    .lock      = PTHREAD_MUTEX_INITIALIZER,
+    .workReady = PTHREAD_COND_INITIALIZER,
+    .allDone   = PTHREAD_COND_INITIALIZER,
+};
+
+/* total search threads (workers + caller); 0 = one per online CPU */
+static int g_threadCount = 0;
+static int g_parallelMode = HARD_BOT_LAZY_SMP;
+
+/* pop the next job; caller holds the lock */
+static int pool_pop(PoolJob *out) {
+    if (g_pool.queued == 0) return 0;
+    *out = g_pool.queue[g_pool.head];
+    g_pool.head = (g_pool.head + 1) % POOL_QUEUE_SIZE;
+    g_pool.queued--;
+    g_pool.active++;
+    return 1;
+}
 
-    if (!can_play(&task->root, task->col)) {
-        task->valid = 0;
-        return NULL;
+/* run a popped job and account for it; caller holds the lock */
+static void pool_run(PoolJob job) {
+    pthread_mutex_unlock(&g_pool.lock);
+    job.fn(job.arg);
+    pthread_mutex_lock(&g_pool.lock);
+
+    g_pool.active--;
+    if (g_pool.active == 0 && g_pool.queued == 0) {
+        pthread_cond_broadcast(&g_pool.allDone);
     }
+}
 
-    Position child = task->root;
-    play_move(&child, task->col);
+static void *pool_worker(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_pool.lock);
+    for (;;) {
+        PoolJob job;
+        while (!g_pool.shutdown && !pool_pop(&job)) {
+            pthread_cond_wait(&g_pool.workReady, &g_pool.lock);
+        }
+        if (g_pool.shutdown) break;
+        pool_run(job);
+    }
+    pthread_mutex_unlock(&g_pool.lock);
+    return NULL;
+}
 
-    int a = task->alpha;
-    int b = task->beta;
+static void pool_submit(PoolFn fn, void *arg) {
+    pthread_mutex_lock(&g_pool.lock);
+    if (g_pool.queued == POOL_QUEUE_SIZE) {
+        pthread_mutex_unlock(&g_pool.lock);
+        fn(arg);                   /* queue full: run it ourselves */
+        return;
+    }
+    int slot = (g_pool.head + g_pool.queued) % POOL_QUEUE_SIZE;
+    g_pool.queue[slot].fn  = fn;
+    g_pool.queue[slot].arg = arg;
+    g_pool.queued++;
+    pthread_cond_signal(&g_pool.workReady);
+    pthread_mutex_unlock(&g_pool.lock);
+}
 
-    int val = -negamax(&child, task->depth - 1,
-                       -b, -a,
-                       task->thread_id, 1);
+/* help run queued jobs, then block until every job has finished */
+static void pool_wait(void) {
+    pthread_mutex_lock(&g_pool.lock);
+    PoolJob job;
+    while (pool_pop(&job)) {
+        pool_run(job);
+    }
+    while (g_pool.active > 0 || g_pool.queued > 0) {
+        pthread_cond_wait(&g_pool.allDone, &g_pool.lock);
+    }
+    pthread_mutex_unlock(&g_pool.lock);
+}
+
+static inline int pool_thread_count(void) {
+    return g_pool.workerCount + 1;
+}
 
-    if (timeExpired) {
-        task->valid = 0;
-        return NULL;
+static void pool_start(int threads) {
+    if (threads <= 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (n < 1) ? 1 : (int)n;
+    }
+    if (threads > SMP_MAX_THREADS) threads = SMP_MAX_THREADS;
+
+    g_pool.shutdown    = 0;
+    g_pool.workerCount = 0;
+    for (int i = 0; i < threads - 1; ++i) {
+        if (pthread_create(&g_pool.workers[i], NULL, pool_worker, NULL) != 0) {
+            fprintf(stderr, "[HARD BOT] could only start %d of %d search threads.\n",
+                    i + 1, threads);
+            break;
+        }
+        g_pool.workerCount++;
     }
+}
 
-    task->score = val;
-    task->valid = 1;
-    return NULL;
+static void pool_stop(void) {
+    pthread_mutex_lock(&g_pool.lock);
+    g_pool.shutdown = 1;
+    pthread_cond_broadcast(&g_pool.workReady);
+    pthread_mutex_unlock(&g_pool.lock);
+
+    for (int i = 0; i < g_pool.workerCount; ++i) {
+        pthread_join(g_pool.workers[i], NULL);
+    }
+    g_pool.workerCount = 0;
 }
 
 #endif
@@ -845,88 +2223,54 @@ static void root_search(Position *root,
                         int depth,
                         int alpha,
                         int beta,
+                        int thread_id,
                         int *outBestMove,
                         int *outBestScore) {
-#if USE_THREADS
-    pthread_t threads[NUM_THREADS];
-    ThreadTask tasks[NUM_THREADS];
-    int taskCount = 0;
+    /* every Lazy SMP thread runs this on its own; with YBWC the root
+       splits like any other node */
+    Position children[COLS];
+    int cols[COLS];
+    int count = 0;
 
-    /* prepare tasks per playable column (still center-first at root) */
-    for (int i = 0; i < COLS && taskCount < NUM_THREADS; ++i) {
+    for (int i = 0; i < COLS; ++i) {
         int col = moveOrder[i];
         if (!can_play(root, col)) continue;
 
-        tasks[taskCount].root      = *root;
-        tasks[taskCount].depth     = depth;
-        tasks[taskCount].col       = col;
-        tasks[taskCount].thread_id = taskCount;
-        tasks[taskCount].alpha     = alpha;
-        tasks[taskCount].beta      = beta;
-        tasks[taskCount].score     = -INF_SCORE;
-        tasks[taskCount].valid     = 0;
-
-        pthread_create(&threads[taskCount], NULL, thread_search, &tasks[taskCount]);
-        taskCount++;
-    }
-
-    /* wait for all searches to finish */
-    for (int i = 0; i < taskCount; ++i) {
-        pthread_join(threads[i], NULL);
-    }
-
-    if (timeExpired) {
-        *outBestMove  = 3;
-        *outBestScore = -INF_SCORE;
-        return;
+        children[count] = *root;
+        play_move(&children[count], col);
+        cols[count++] = col;
     }
 
-    int localBestMove  = -1;
-    int localBestScore = -INF_SCORE;
-
-    for (int i = 0; i < taskCount; ++i) {
-        if (!tasks[i].valid) continue;
-        if (tasks[i].score > localBestScore) {
-            localBestScore = tasks[i].score;
-            localBestMove  = tasks[i].col;
-        }
-    }
-
-    if (localBestMove == -1) {
-        *outBestMove  = 3;
-        *outBestScore = -INF_SCORE;
-    } else {
-        *outBestMove  = localBestMove;
-        *outBestScore = localBestScore;
-    }
-
-#else
-    /* single-threaded root */
     int localBestMove  = -1;
     int localBestScore = -INF_SCORE;
     int localAlpha = alpha;
 
-    for (int i = 0; i < COLS; ++i) {
-        int col = moveOrder[i];
-        if (!can_play(root, col)) continue;
-
-        Position child = *root;
-        play_move(&child, col);
-
-        int val = -negamax(&child, depth - 1,
+    for (int i = 0; i < count; ++i) {
+        int val = -negamax(&children[i], depth - 1,
                            -beta, -localAlpha,
-                           0, 1);
+                           thread_id, 1);
 
-        if (timeExpired) break;
+        if (search_stopped()) break;
 
+        if (val >= PROVEN_WIN && val > localAlpha) {
+            publish_root_win(cols[i], val);
+        }
         if (val > localBestScore) {
             localBestScore = val;
-            localBestMove  = col;
+            localBestMove  = cols[i];
         }
         if (val > localAlpha) {
             localAlpha = val;
         }
         if (localAlpha >= beta) break;
+
+#if USE_THREADS
+        if (i == 0 && count > 2 && split_wanted(thread_id)) {
+            split_node(root, children, cols, count, depth, &localAlpha, beta,
+                       &localBestScore, &localBestMove, thread_id, 0);
+            break;
+        }
+#endif
     }
 
     if (localBestMove == -1) {
@@ -936,54 +2280,57 @@ static void root_search(Position *root,
         *outBestMove  = localBestMove;
         *outBestScore = localBestScore;
     }
-#endif
 }
 
 /* ===============================================================
-   Public entry point
+   Iterative deepening + aspiration windows (run by every thread)
    =============================================================== */
 
-int getBotMoveHard(char board[ROWS][COLS], char bot, char opponent) {
-      initHardBot();
-
-   
-    static int initialized = 0;
-    if (!initialized) {
-        init_masks();
-        memset(tt, 0, sizeof(tt));
-        initialized = 1;
-    }
-
-    /* Clear TT for each move to avoid cross-game pollution
-       and make timing more predictable. */
-    memset(tt, 0, sizeof(tt));
-
+typedef struct {
     Position root;
-    load_board(&root, board, bot, opponent);
+    int thread_id;
+    int bestMove;       /* best move of last completed depth */
+    int bestScore;
+    int depth;          /* last completed depth (0 = none)   */
+} SearchResult;
+
+/* Lazy SMP helpers skip depths, each in a pattern of its own: helper
+ * n uses entry (n - 1) % SMP_SKIP_PATTERNS and skips depth d when
+ * (d + phase) / size is odd. At any moment the threads are then
+ * spread over several depths instead of all running the same
+ * iteration; the main thread (0) searches every depth. */
+#define SMP_SKIP_PATTERNS 20
+static const int skipSize[SMP_SKIP_PATTERNS]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                                  3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const int skipPhase[SMP_SKIP_PATTERNS] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                                                  4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+static inline int skips_depth(int thread_id, int depth) {
+    if (thread_id == 0) return 0;
+    int i = (thread_id - 1) % SMP_SKIP_PATTERNS;
+    return ((depth + skipPhase[i]) / skipSize[i]) % 2 != 0;
+}
 
-    /* ---- Try Pascal opening book first (perfect moves up to depth 14) ---- */
-    int bookMove;
-    if (try_opening_book(&root, &bookMove) && can_play(&root, bookMove)) {
-        printf("[HARD BOT] opening book move=%d\n", bookMove + 1);
-        return bookMove + 1;
-    }
+static void iterative_deepening(SearchResult *res) {
+    Position *root = &res->root;
 
-    startTime        = clock();
-    timeExpired      = 0;
-    lastCompletedDepth = 0;
-    lastSelectiveDepth = 0;
+    int maxDepth = ROWS * COLS - root->moves;
+    if (g_limits.depth > 0 && g_limits.depth < maxDepth) maxDepth = g_limits.depth;
+    if (maxDepth < 1) maxDepth = 1;
 
     int bestMove  = 3;            /* default to center */
     int bestScore = -INF_SCORE;
-
-    int maxDepth = ROWS * COLS - root.moves;
-    if (maxDepth < 1) maxDepth = 1;
-
     int lastScore = 0;
     int haveLast  = 0;
 
+    res->bestMove  = bestMove;
+    res->bestScore = bestScore;
+    res->depth     = 0;
+
     for (int depth = 1; depth <= maxDepth; ++depth) {
-        if (timeExpired || time_up()) break;
+        if (limits_reached()) break;
+        /* the last depth is never skipped, so every thread finishes */
+        if (depth < maxDepth && skips_depth(res->thread_id, depth)) continue;
 
         int alpha = -INF_SCORE;
         int beta  =  INF_SCORE;
@@ -997,12 +2344,12 @@ int getBotMoveHard(char board[ROWS][COLS], char bot, char opponent) {
             if (alpha < -INF_SCORE) alpha = -INF_SCORE;
             if (beta  >  INF_SCORE) beta  =  INF_SCORE;
 
-            while (!timeExpired && !time_up()) {
+            while (!limits_reached()) {
                 int localBestMove, localBestScore;
-                root_search(&root, depth, alpha, beta,
+                root_search(root, depth, alpha, beta, res->thread_id,
                             &localBestMove, &localBestScore);
 
-                if (timeExpired || time_up()) break;
+                if (limits_reached()) break;
 
                 if (localBestScore <= alpha) {
                     /* fail-low: widen window downward */
@@ -1023,20 +2370,246 @@ int getBotMoveHard(char board[ROWS][COLS], char bot, char opponent) {
             }
         } else {
             /* First depth: full window */
-            root_search(&root, depth, alpha, beta, &bestMove, &bestScore);
+            root_search(root, depth, alpha, beta, res->thread_id,
+                        &bestMove, &bestScore);
         }
 
-        if (timeExpired || time_up()) break;
+        if (limits_reached()) break;
 
         lastScore = bestScore;
         haveLast  = 1;
-        lastCompletedDepth = depth;
+
+        res->bestMove  = bestMove;
+        res->bestScore = bestScore;
+        res->depth     = depth;
 
         /* found forced win; no need to go deeper */
-        if (bestScore >= WIN_SCORE - 1000) {
+        if (bestScore >= PROVEN_WIN) {
             break;
         }
     }
+}
+
+#if USE_THREADS
+
+static void smp_helper(void *arg) {
+    iterative_deepening((SearchResult *)arg);
+}
+
+#endif
+
+/* ===============================================================
+   Public entry points
+   =============================================================== */
+
+static int hardBotInitialized = 0;
+
+void initHardBot(void) {
+    if (hardBotInitialized) return;
+    hardBotInitialized = 1;
+
+    init_masks();
+    pascal_book_load(PASCAL_BOOK_FILE);
+    if (!tt) tt_alloc();
+#if USE_THREADS
+    pool_start(g_threadCount);
+    split_init();
+#endif
+}
+
+void setHardBotLimits(const HardBotLimits *limits) {
+    g_limits = *limits;
+}
+
+void stopHardBot(void) {
+    atomic_fetch_add(&g_stopRequests, 1);
+    stop_search();
+}
+
+void newGameHardBot(void) {
+    tt_new_game();
+}
+
+void setHardBotHashMB(size_t mb) {
+    if (mb < 1) mb = 1;
+    ttRequestedMB = mb;
+    tt_free();   /* remapped at the requested size by the next search */
+}
+
+void setHardBotParallelMode(int mode) {
+#if USE_THREADS
+    g_parallelMode = (mode == HARD_BOT_YBWC) ? HARD_BOT_YBWC : HARD_BOT_LAZY_SMP;
+#else
+    (void)mode;
+#endif
+}
+
+void setHardBotSolverEmpties(int empties) {
+    g_solverEmpties = (empties < 0) ? 0 : empties;
+}
+
+void setHardBotThreads(int threads) {
+#if USE_THREADS
+    if (threads < 1) threads = 1;
+    if (threads > SMP_MAX_THREADS) threads = SMP_MAX_THREADS;
+    g_threadCount = threads;
+
+    if (hardBotInitialized) {
+        pool_stop();
+        pool_start(g_threadCount);
+    }
+#else
+    (void)threads;
+#endif
+}
+
+int solveHardBotPosition(uint64_t position, uint64_t mask, int moves, int thread,
+                         int *score) {
+    initHardBot();
+    if (!tt) tt_alloc();
+    if (thread < 0 || thread >= SMP_MAX_THREADS) thread = 0;
+
+    /* the limits count from this call and for this caller alone */
+    SearchThread *st = &g_threads[thread];
+    st->solo     = 1;
+    st->stopped  = 0;
+    st->nodes    = 0;
+    st->unpolled = 0;
+    st->stopRequests = atomic_load(&g_stopRequests);
+    clock_gettime(CLOCK_MONOTONIC, &st->start);
+
+    Position p;
+    p.position = position;
+    p.mask     = mask;
+    p.moves    = moves;
+    init_position(&p);
+    *score = solve_exact(&p, st);
+    return !st->stopped;
+}
+
+uint64_t hardBotBookKey(uint64_t position, uint64_t mask, int moves) {
+    PascalPos P;
+    P.current_position = position;
+    P.mask             = mask;
+    P.moves            = (unsigned int)moves;
+    return pascal_key3(&P);
+}
+
+int getBotMoveHard(char board[ROWS][COLS], char bot, char opponent) {
+    initHardBot();
+
+    Position root;
+    load_board(&root, board, bot, opponent);
+
+    /* A stone disappearing since our last move means a new game. */
+    static uint64_t lastRootMask = 0;
+    if ((lastRootMask & ~root.mask) != 0ULL) {
+        tt_new_game();
+    }
+    lastRootMask = root.mask;
+
+    if (!tt) tt_alloc();
+    tt_new_search();
+
+    /* ---- Try Pascal opening book first (perfect moves up to depth 14) ---- */
+    int bookMove;
+    if (try_opening_book(&root, &bookMove) && can_play(&root, bookMove)) {
+        printf("[HARD BOT] opening book move=%d\n", bookMove + 1);
+        return bookMove + 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    atomic_store(&stopSearch, 0);
+    g_moveStopRequests = atomic_load(&g_stopRequests);
+    atomic_store(&g_rootWin, 0);
+    atomic_store(&totalNodes, 0);
+    memset(g_threads, 0, sizeof(g_threads));
+    for (int i = 0; i < SMP_MAX_THREADS; ++i) {
+        memset(g_threads[i].killers, -1, sizeof(g_threads[i].killers));
+    }
+    lastCompletedDepth = 0;
+
+    /* ---- Endgame: solve it exactly ---- */
+    int solveMove = -1;
+    if (ROWS * COLS - root.moves <= g_solverEmpties) {
+        int solveScore;
+        g_budgetShare = SOLVER_BUDGET_SHARE;
+        int solved = solve_root(&root, &g_threads[0], &solveMove, &solveScore);
+        g_budgetShare = 1.0;
+        if (solved) {
+            printf("[HARD BOT] solver score=%+d  nodes=%llu  time=%.3f s  move=%d\n",
+                   solveScore, (unsigned long long)g_threads[0].nodes,
+                   elapsed_sec(), solveMove + 1);
+            return solveMove + 1;
+        }
+        printf("[HARD BOT] solver stopped  nodes=%llu  time=%.3f s  move=%d\n",
+               (unsigned long long)g_threads[0].nodes, elapsed_sec(), solveMove + 1);
+
+        /* out of its share of the limits: search with the rest, unless
+           stopHardBot() ended the move */
+        if (atomic_load(&g_stopRequests) != g_moveStopRequests) {
+            return solveMove + 1;
+        }
+        atomic_store(&stopSearch, 0);
+    }
+
+    SearchResult mainRes;
+    mainRes.root       = root;
+    mainRes.thread_id  = 0;
+
+#if USE_THREADS
+    int helperCount = pool_thread_count() - 1;
+    SearchResult helperRes[SMP_MAX_THREADS];
+    int helperIds[SMP_MAX_THREADS];
+
+    if (g_parallelMode == HARD_BOT_YBWC) {
+        split_set_done(0);
+        for (int i = 0; i < helperCount; ++i) {
+            helperIds[i] = i + 1;
+            pool_submit(split_helper, &helperIds[i]);
+        }
+    } else {
+        for (int i = 0; i < helperCount; ++i) {
+            helperRes[i].root       = root;
+            helperRes[i].thread_id  = i + 1;
+            pool_submit(smp_helper, &helperRes[i]);
+        }
+    }
+#endif
+
+    iterative_deepening(&mainRes);
+
+    int bestMove = mainRes.bestMove;
+    lastCompletedDepth = mainRes.depth;
+
+#if USE_THREADS
+    if (g_parallelMode == HARD_BOT_YBWC) {
+        /* the search is over: release the helpers */
+        split_set_done(1);
+        pool_wait();
+    } else {
+        /* main thread is done: stop the helpers, then take the deepest result */
+        stop_search();
+        pool_wait();
+        for (int i = 0; i < helperCount; ++i) {
+            if (helperRes[i].depth > lastCompletedDepth) {
+                lastCompletedDepth = helperRes[i].depth;
+                bestMove = helperRes[i].bestMove;
+            }
+        }
+    }
+#endif
+
+    /* no depth completed after an interrupted solve: keep its guess */
+    if (lastCompletedDepth == 0 && solveMove >= 0) {
+        bestMove = solveMove;
+    }
+
+    /* a root win proven by any thread beats every completed depth */
+    long long rootWin = atomic_load(&g_rootWin);
+    if (rootWin != 0) {
+        bestMove = (int)(rootWin & 0xFF);
+    }
 
     /* fallback: find any legal column if bestMove is invalid */
     if (!can_play(&root, bestMove)) {
@@ -1048,10 +2621,20 @@ int getBotMoveHard(char board[ROWS][COLS], char bot, char opponent) {
         }
     }
 
-    double elapsed = (double)(clock() - startTime) / CLOCKS_PER_SEC;
-    printf("[HARD BOT] depth=%d  selective=%d  time=%.3f s  move=%d\n",
-           lastCompletedDepth, lastSelectiveDepth, elapsed, bestMove + 1);
+    uint64_t nodes = 0, bookProbes = 0, bookHits = 0;
+    int selDepth = 0;
+    for (int i = 0; i < SMP_MAX_THREADS; ++i) {
+        nodes      += g_threads[i].nodes;
+        bookProbes += g_threads[i].bookProbes;
+        bookHits   += g_threads[i].bookHits;
+        if (g_threads[i].selDepth > selDepth) selDepth = g_threads[i].selDepth;
+    }
+
+    double elapsed = elapsed_sec();
+    printf("[HARD BOT] depth=%d  selective=%d  nodes=%llu  book=%llu/%llu  time=%.3f s  move=%d\n",
+           lastCompletedDepth, selDepth, (unsigned long long)nodes,
+           (unsigned long long)bookHits, (unsigned long long)bookProbes,
+           elapsed, bestMove + 1);
 
     return bestMove + 1;
 }
-
@@ -1,9 +1,82 @@
 #ifndef BOT_HARD_H
 #define BOT_HARD_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define ROWS 6
 #define COLS 7
 
+/* Per-move search limits; a zero field means "no limit". */
+typedef struct {
+    double   timeSec;    /* wall-clock budget in seconds              */
+    uint64_t nodes;      /* node budget summed over all threads       */
+    int      depth;      /* max iterative-deepening depth             */
+    int      infinite;   /* ignore time/nodes, search until stopHardBot */
+} HardBotLimits;
+
 int getBotMoveHard(char board[ROWS][COLS], char bot, char opponent);
 
+/* Maps the TT and opening book and starts the search thread pool;
+   called lazily by getBotMoveHard. */
+void initHardBot(void);
+
+/* Number of search threads (including the caller), default one per
+   online CPU. Must not be called while a move is being searched. */
+void setHardBotThreads(int threads);
+
+/* How the threads share a move: HARD_BOT_LAZY_SMP (default, every
+   thread searches the whole tree, sharing only the TT) or
+   HARD_BOT_YBWC (young brothers wait: idle threads steal the remaining
+   moves of nodes whose first move is searched). Must not be called
+   while a move is being searched. */
+enum { HARD_BOT_LAZY_SMP = 0, HARD_BOT_YBWC = 1 };
+void setHardBotParallelMode(int mode);
+
+/* Empty cells at or below which the bot switches from the heuristic
+   search to the exact solver (default 20, 0 = never). A solve still
+   running at half the time or node limit gives way to the heuristic
+   search for the rest of the move. */
+void setHardBotSolverEmpties(int empties);
+
+/* Checks the opening book header against its file size without
+   reading the payload (NULL = the default 7x6.book). Returns 1 if the
+   bot will be able to use it. */
+int validateHardBotBook(const char *filename);
+
+/* Transposition table size in MB (default 64, rounded down to a power
+   of two). The table is only mapped by the first search; a new size
+   drops the current table. Must not be called during a search. */
+void setHardBotHashMB(size_t mb);
+
+/* Replaces the search limits (default: 9.8 s per move). */
+void setHardBotLimits(const HardBotLimits *limits);
+
+/* Asks a running search to return its best move so far; safe to call
+   from another thread. */
+void stopHardBot(void);
+
+/* Forgets what the search learned in previous games (O(1), no clear).
+   A board that is not a continuation of the last one does this too. */
+void newGameHardBot(void);
+
+/* ---- Offline tools (book_gen.c) ----
+   Positions use the bot's bitboard layout: 7 bits per column, bit 0
+   at the bottom, `position` = stones of the player to move, `mask` =
+   all stones. Call initHardBot() once before using these from several
+   threads. */
+
+/* Exact Pascal-style score into *score: > 0 the side to move wins (the
+   larger the sooner), < 0 it loses, 0 draw. Returns 1 when solved, 0
+   when the limits of setHardBotLimits() or a stopHardBot() issued
+   during the call interrupted it; *score is meaningless then. Time and
+   nodes count from this call and for this caller only. `thread`
+   (0..63) picks the per-thread search state; concurrent callers must
+   pass different values. */
+int solveHardBotPosition(uint64_t position, uint64_t mask, int moves, int thread,
+                         int *score);
+
+/* Symmetric base-3 key used by 7x6.book (same for mirrored boards). */
+uint64_t hardBotBookKey(uint64_t position, uint64_t mask, int moves);
+
 #endif